@@ -1,40 +1,45 @@
 #ifndef __INTERNAL_CONCCURENT_QUEUE_HXX__
 #define __INTERNAL_CONCCURENT_QUEUE_HXX__
 
-#include <queue>
+#include <vector>
 #include "../../tools/OMP/openMP_interface.hxx"
 
 #include "../../internal/namespace.header"
 
 namespace internal {
 
+  // A lock-free FIFO of thread indices waiting for their turn to access a shared
+  // resource. Any thread may enrol concurrently (multiple producers), but only the
+  // thread at the front of the queue (i.e. availableFor()) may call done() to hand
+  // over to the next one, so the head is only ever written by a single thread.
+  // Each index can be enroled at most once at a time, so a ring buffer with one slot
+  // per index is enough to hold the queue.
+  // NB: enrol(index) and done(index) must always be called by the same thread.
   class ConccurentQueue {
   public:
     ConccurentQueue():
-      nextAvail(-1)
+      head(0),tail(0)
     {}
 
+    // Not thread safe
     void clear()
     {
-#pragma omp critical(CQUEUE)
-      {	
-	enroled.clear();
-	std::queue<int> empty;
-	q.swap(empty);
-      }
+      enroled.assign(enroled.size(),0);
+      ring.assign(ring.size(),-1);
+      head=0;
+      tail=0;
     }
 
+    // Not thread safe
     void resize(long sz)
     {
-#pragma omp critical(CQUEUE)
-      {
-	enroled.resize(sz,0);
-      }
+      enroled.resize(sz,0);
+      ring.resize(sz,-1);
     }
 
     long nWaiting() const
     {
-      return q.size();
+      return loadTail()-loadHead();
     }
 
     bool isEnroled(int index) const
@@ -45,39 +50,74 @@ namespace internal {
     bool enrol(int index)
     {
       if (enroled[index]) return false;
-#pragma omp critical(CQUEUE)
-      {	
-	q.push(index);
-	if (q.size()==1) nextAvail=index;
-	enroled[index]=1;
+      enroled[index]=1;
+
+      long ticket;
+#pragma omp atomic capture seq_cst
+      {
+	// fetch_and_add
+	ticket=tail;
+	tail=tail+1;
       }
+      // At most ring.size() indices are enroled at any time, so the slot was already
+      // released by done()
+      int *slot=&ring[ticket%ring.size()];
+#pragma omp atomic write seq_cst
+      (*slot)=index;
+
       return true;
     }
 
+    // Returns the index at the front of the queue or -1 if the queue is empty (or if
+    // the front index is still being enroled)
     int availableFor() const
-    {            
-      return nextAvail;      
+    {
+      long h=loadHead();
+      if (h==loadTail()) return -1;
+
+      int result;
+      const int *slot=&ring[h%ring.size()];
+#pragma omp atomic read seq_cst
+      result=(*slot);
+      return result;
     }
-    
+
     bool done(int index)
     {
-      if (index==nextAvail)
-	{
-#pragma omp critical(CQUEUE)
-	  {	    
-	    q.pop();
-	    if (q.size()==0) nextAvail=-1;
-	    else nextAvail=q.front();
-	    enroled[index]=0;
-	  }
-	  return true;
-	}
-      return false;
+      if (availableFor()!=index) return false;
+
+      // Only the front thread gets here, so it is the only one to update head
+      long h=head;
+      int *slot=&ring[h%ring.size()];
+#pragma omp atomic write seq_cst
+      (*slot)=-1;
+      enroled[index]=0;
+#pragma omp atomic write seq_cst
+      head=h+1;
+
+      return true;
     }
 
   private:
-    volatile int nextAvail;
-    std::queue<int> q;
+    long loadHead() const
+    {
+      long result;
+#pragma omp atomic read seq_cst
+      result=head;
+      return result;
+    }
+
+    long loadTail() const
+    {
+      long result;
+#pragma omp atomic read seq_cst
+      result=tail;
+      return result;
+    }
+
+    long head;
+    long tail;
+    std::vector<int> ring;
     std::vector<int> enroled;
   };
 
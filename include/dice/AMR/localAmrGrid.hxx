@@ -937,6 +937,8 @@ public:
    * 2 or 3: simplex is very close to degenerate
    * \param[in] nThreads the number of threads to use, -1 to use as many as possible   
    * \param[in] verbose if true, progression and timings will be printed to the console
+   * \param[out] simplexCost if not NULL, the work needed to project each local simplex
+   * is stored at the simplex local index (see LocalAmrGridProjectorT::setSimplexCostOutput)
    * \return the number of simplices that had to be reprojected
    * \tparam M  unstructured mesh type
    * \tparam WF the class of the weight functor that implements a 
@@ -960,10 +962,12 @@ public:
 		    double accLevel=checkAccuracy?0.1:0,
 		    bool checkTags=true,
 		    int nThreads=glb::num_omp_threads,
-		    bool verbose=false)
+		    bool verbose=false,
+		    std::vector<double> *simplexCost=NULL)
   {
     typedef LocalAmrGridProjectorT<MyType,M,checkAccuracy,IF,HF,SF> Projector;
     Projector projector(this,mesh,accLevel,nThreads,verbose);
+    projector.setSimplexCostOutput(simplexCost);
     return projector.template project<WF>(wf,checkTags);   
   }
 
@@ -981,6 +985,8 @@ public:
    * 2 or 3: simplex is very close to degenerate
    * \param[in] nThreads the number of threads to use, -1 to use as many as possible   
    * \param[in] verbose if true, progression and timings will be printed to the console
+   * \param[out] simplexCost if not NULL, the work needed to project each local simplex
+   * is stored at the simplex local index (see LocalAmrGridProjectorT::setSimplexCostOutput)
    * \return the number of simplices that had to be reprojected
    * \tparam M  unstructured mesh type
    * \tparam WF The class of the weight functor that implements a 
@@ -1009,10 +1015,12 @@ public:
 		    double accLevel=checkAccuracy?0.1:0,
 		    bool checkTags=true,
 		    int nThreads=glb::num_omp_threads, 
-		    bool verbose=false)
+		    bool verbose=false,
+		    std::vector<double> *simplexCost=NULL)
   {
     typedef LocalAmrGridProjectorT<MyType,M,checkAccuracy,IF,HF,SF> Projector;
     Projector projector(this,mesh,accLevel,nThreads,verbose);
+    projector.setSimplexCostOutput(simplexCost);
     return projector.template project<WF,WDF>(wf,wdf,checkTags);   
   }
   
@@ -288,6 +288,7 @@ public:
     nThreads(nThreads_),
     //mpiCom(mpiCom_),
     verbose(verbose_),
+    simplexCost(NULL),
     samplesPerVoxel(10),
     contribSumInterface(amr,accLevel)
     //highPrecisionBase(amr_,mesh_,nThreads_)
@@ -474,6 +475,18 @@ public:
     return samplesPerVoxel;
   }
 
+  /** 
+   * \brief Measure the work needed to project each local simplex during the next 
+   * projection. The work is estimated from the number of voxel contributions computed
+   * while processing each vertex, shared evenly among its incident simplices. On 
+   * output, (*cost)[s->getLocalIndex()] is the work of local simplex s.
+   * \param cost where to store the result, or NULL to disable measurement (default).
+   */
+  void setSimplexCostOutput(std::vector<double> *cost)
+  {
+    simplexCost=cost;
+  }
+
 private:
   AMR *amr;
   MESH *mesh;
@@ -497,6 +510,8 @@ private:
   int busyFlag;
   internal::ConccurentQueue cQueue;
   bool verbose;
+  std::vector<double> *simplexCost;
+  std::vector<double> vertexCost;
    
   long samplesPerVoxel;
 
@@ -603,6 +618,9 @@ private:
     
     double incidenceTime = initTimer->check();   
 
+    // The work is accumulated over all the passes
+    if (simplexCost!=NULL) vertexCost.assign(iIndex.size(),0);
+
     // Identify individual vertices and segments of the AMR grid
     if (verbose) glb::console->printFlush<LOG_PEDANTIC>("(AMR)");
     // note : we only need voxel segments for NDIM==3 (hence the NDIM>2)
@@ -771,6 +789,8 @@ private:
 	  }   
       }
 
+    if (simplexCost!=NULL) computeSimplexCost(iIndex);
+
     // Assign the computed values to the voxels and apply correction factor
     contribSumInterface.commit(nThreads);
     amr->visitTree(CorrectDimFactorVisitorT<true>(amr,dimFactor),nThreads); 
@@ -1024,6 +1044,7 @@ private:
 	*/
 	Vertex *vertex = (*it);
 	Voxel *voxel = amr->getVoxelAt(vertex->getCoordsConstPtr());
+	const long nProcessedBefore=nProcessed;
 	
 	// Simplices incident to vertex
 	Simplex * const *iSimplex = &incidentSimplices[iIndex[vertex->getLocalIndex()]];
@@ -1227,11 +1248,43 @@ private:
 	    if (ownSimplex) 
 	      nProcessed+=addVoxelContribs<Base,Pass>(simplex,overlap,weightFunctor,out);
 	  }
+
+	// Each vertex is processed by a single thread
+	if (!vertexCost.empty())
+	  vertexCost[vertex->getLocalIndex()] += 1+nProcessed-nProcessedBefore;
       }
     
     return nProcessed;
   }
 
+  // Share the work measured for each vertex evenly among its incident simplices
+  template <typename IT>
+  void computeSimplexCost(const std::vector<IT> &iIndex)
+  {
+    simplexCost->assign(mesh->getNSimplices(),0);
+
+    FOREACH_THREAD_SIMPLEX(mesh,nThreads,th,it)
+      {
+	for (;it!=it_end;++it)
+	  {
+	    Simplex *simplex=(*it);
+	    double cost=0;
+	    for (int i=0;i<Simplex::NVERT;++i)
+	      {
+		Vertex *v=simplex->getVertex(i);
+		if (!v->isLocal()) continue;
+		const IT id=v->getLocalIndex();
+		const IT nIncident=iIndex[id+1]-iIndex[id];
+		if (nIncident>0) cost+=vertexCost[id]/nIncident;
+	      }
+	    (*simplexCost)[simplex->getLocalIndex()]=cost;
+	  }
+      }
+    FOREACH_THREAD_END;
+
+    vertexCost.clear();
+  }
+
   // This function computes the contributions from the intersection of a given simplex with 
   // the voxel's vertices as well as that from the voxel edges intersection with 
   // the simplex facets (the later is only needed in 3D)
@@ -12,6 +12,7 @@ class Console;
 class ParamsParser;
 class MemoryInspector;
 class TimerPool;
+class ScratchArenas;
 
 namespace glb {
   GLOBAL MpiCommunication *mpiComWorld;
@@ -20,6 +21,7 @@ namespace glb {
   GLOBAL ParamsParser *dummyPParser;
   GLOBAL MemoryInspector *memoryInspector;
   GLOBAL TimerPool *timerPool;
+  GLOBAL ScratchArenas *scratchArenas;
   GLOBAL int debug;
   GLOBAL int num_omp_threads;
   GLOBAL int global_stop_signal;
@@ -44,6 +46,7 @@ namespace glb {
 #include "./tools/IO/paramsParser.hxx"
 #include "./tools/OMP/openMP_interface.hxx"
 #include "./tools/memory/memoryInspector.hxx"
+#include "./tools/memory/scratchArena.hxx"
 
 #ifdef HAVE_EIGEN3
 #ifdef NDEBUG
@@ -106,7 +109,36 @@ struct GlobalObjects
 					glb::console->getVerboseLevel(),
 					"Verbosity level (from 0=quiet to 4=debug)")
 				  );
-    
+
+    // This must be done before anything depends on the MPI ranks
+    std::string mpiReorder=glb::pParser->get<>("mpiReorder",
+					       ParamsParser::defaultCategory(),
+					       std::string("NONE"),
+					       "Renumber MPI processes at startup to match the hardware topology: NONE, NODE (processes sharing a node get contiguous ranks) or GRAPH (let MPI map a chain of processes onto the topology)");
+    if ((mpiReorder!="NONE")&&(initializeMpi))
+      {
+	MpiCommunication::RankReordering mode=MpiCommunication::REORDER_NONE;
+	if (mpiReorder=="NODE") mode=MpiCommunication::REORDER_NODE;
+	else if (mpiReorder=="GRAPH") mode=MpiCommunication::REORDER_GRAPH;
+	else glb::console->print<LOG_WARNING>("Unknown value for mpiReorder ('%s'), ignoring.\n",
+					      mpiReorder.c_str());
+
+	int oldRank=glb::mpiComWorld->rank();
+	if (glb::mpiComWorld->reorderRanks(mode))
+	  glb::console->print<LOG_INFO_ALL>("MPI process %d was renumbered %d (mpiReorder=%s).\n",
+					    oldRank,glb::mpiComWorld->rank(),mpiReorder.c_str());
+      }
+
+    long mpiProgressThread=glb::pParser->get<>("mpiProgressThread",
+					       ParamsParser::defaultCategory(),
+					       0L,
+					       "Set to a polling period in microseconds to start a thread that drives MPI communications in the background, so that non blocking transfers overlap with computations (0 to disable, requires MPI_THREAD_MULTIPLE support)");
+    if ((mpiProgressThread>0)&&(initializeMpi))
+      {
+	if (!glb::mpiComWorld->startProgressThread(mpiProgressThread))
+	  glb::console->print<LOG_WARNING>("Could not start the MPI progress thread (MPI_THREAD_MULTIPLE and pthreads are required).\n");
+      }
+
     int noGlobalLog=glb::pParser->get<>("noGlobalLog",
 					ParamsParser::defaultCategory(),
 					enableGlobalLog?0:1,
@@ -187,6 +219,10 @@ struct GlobalObjects
 #endif
 #endif
     
+    // One arena per thread for short lived temporaries
+    glb::scratchArenas = new ScratchArenas(std::max(glb::num_omp_threads,
+						    omp_get_max_threads()));
+
     glb::debugMeshRefine=0;
     glb::debugMeshRefine=glb::pParser->get<>("meshRefine",
 					     "glbDebug",
@@ -208,6 +244,8 @@ struct GlobalObjects
     delete glb::pParser;
     delete glb::dummyPParser;
     delete glb::memoryInspector;
+    delete glb::scratchArenas;
+    glb::scratchArenas=NULL;
 
     glb::mpiComWorld->barrier();
 
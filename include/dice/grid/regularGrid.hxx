@@ -299,7 +299,10 @@ public:
   explicit RegularGridT(const char *dataName_="value"):
     grid(NULL),
     dataName(dataName_),
-    initialized(false)
+    initialized(false),
+    nodeSharedGather(false),
+    nodeSharedPtr(NULL),
+    nodeSharedSize(0)
   {
     numThreads=glb::num_omp_threads;
   }
@@ -308,6 +311,7 @@ public:
   ~RegularGridT()
   {
     if (grid!=NULL) delete grid;
+    if (nodeSharedPtr!=NULL) mpiCom->freeNodeShared(&nodeSharedWin);
   }  
 
   void clone(MyType &cloned, bool cloneExtraElements=true) const
@@ -321,8 +325,18 @@ public:
     else
       tmpGrid=cloned.grid;    
     
+    // the node shared buffer is not cloned
+    bool nsGather=cloned.nodeSharedGather;
+    void *nsPtr=cloned.nodeSharedPtr;
+    long nsSize=cloned.nodeSharedSize;
+    MPI_Win nsWin=cloned.nodeSharedWin;
+
     cloned = *this;
     cloned.grid = tmpGrid;
+    cloned.nodeSharedGather=nsGather;
+    cloned.nodeSharedPtr=nsPtr;
+    cloned.nodeSharedSize=nsSize;
+    cloned.nodeSharedWin=nsWin;
     grid->clone(*cloned.grid,cloneExtraElements);
   }
 
@@ -335,7 +349,10 @@ public:
   RegularGridT( const MyType& other ):
     grid(NULL),
     dataName("copyConstructed"),
-    initialized(false)
+    initialized(false),
+    nodeSharedGather(false),
+    nodeSharedPtr(NULL),
+    nodeSharedSize(0)
   {
     other.clone(*this);
   }
@@ -990,6 +1007,25 @@ public:
   }
 */
   
+  /** \brief Gather once per node instead of once per process in 
+   * gatherSubsetAtCoords() and gatherAll(). The gathered local grid is then stored in a
+   * buffer shared by all the processes of a node (MPI-3 shared memory window) and 
+   * must be considered read only until the next gather. Only one gathered grid may
+   * be used at a time. This is a collective call.
+   * \return true if gathering per node could be enabled (i.e. MPI-3 is available and
+   * there are several processes on the node)
+   */
+  bool setNodeSharedGather(bool enable=true)
+  {
+    nodeSharedGather=false;
+    if ((enable)&&(mpiCom->size()>1)&&(mpiCom->initNodeCom()))
+      nodeSharedGather=(mpiCom->max(mpiCom->nodeSize())>1);
+    
+    return nodeSharedGather;
+  }
+
+  bool getNodeSharedGather() const {return nodeSharedGather;}
+
   /** \brief Gather from lg the values necessary to apply Kernel at 
    *   coordinates stored in container.
    * \warning Fields must be consecutive or nFields must be 1
@@ -1018,7 +1054,11 @@ public:
     // nFields may have been reinterpreted
     localParams.nFields = getNFields();   
     
-    if ((alwaysInitializeGrid)||(!lg.isInitialized())) 
+    const bool nodeShared = nodeSharedGather && (sz>1);
+    const bool isNodeLeader = mpiCom->isNodeLeader();
+    if (nodeShared)
+      initializeNodeSharedGrid(lg,localParams,alwaysInitializeGrid);
+    else if ((alwaysInitializeGrid)||(!lg.isInitialized())) 
       lg.initialize(localParams);
 	
     lg.setName(dataName.c_str());    
@@ -1069,13 +1109,19 @@ public:
 	return;
       }    
 
-    // Reset the local grid
-    if (getNFields()==1) std::fill_n(lg.getDataPtr(),lg.getNValues(),0);      
-    else
+    // Reset the local grid (only once per node when it is shared, after every process
+    // is done using it)
+    if (nodeShared) mpiCom->syncNodeShared(nodeSharedWin);
+    if ((!nodeShared)||(isNodeLeader))
       {
-	std::fill(typename LocalGrid::oneFieldIterator(lg.begin(),fieldIndex),
-		  typename LocalGrid::oneFieldIterator(lg.end(),fieldIndex),0);
+	if (getNFields()==1) std::fill_n(lg.getDataPtr(),lg.getNValues(),0);      
+	else
+	  {
+	    std::fill(typename LocalGrid::oneFieldIterator(lg.begin(),fieldIndex),
+		      typename LocalGrid::oneFieldIterator(lg.end(),fieldIndex),0);
+	  }
       }
+    if (nodeShared) mpiCom->syncNodeShared(nodeSharedWin);
 
     //std::fill_n(lg.getDataPtr(),lg.getNValues(),0);
 
@@ -1144,6 +1190,11 @@ public:
 	  }
       }
 
+    // When the grid is shared, each process of the node has imprinted the pixels it 
+    // needs and the node leader requests their union. The local parts of the node's
+    // processes are copied directly in gatherAll().
+    if (nodeShared) mpiCom->syncNodeShared(nodeSharedWin);
+
     // Count how many pixels at least must be transfered to each MPI process and compute
     // the dimension of the smallest bounding box containing them all.
     std::vector<int> nSend(sz);
@@ -1158,6 +1209,13 @@ public:
 #pragma omp parallel for num_threads(nThreads)
     for (int rk=0;rk<sz;++rk)
       {
+	if ((nodeShared)&&((!isNodeLeader)||(mpiCom->sameNode(rk))))
+	  {
+	    bboxVolume[rk]=0;
+	    nSend[rk]=0;
+	    continue;
+	  }
+
 	if (rk==mpiCom->rank()) 
 	  {
 	    bboxVolume[rk]=1;
@@ -1499,7 +1557,10 @@ public:
     // because nfields may have been reinterpreted !!!
     localParams.nFields = getNFields();   
     
-    if ((alwaysInitializeGrid)||(!lg.isInitialized())) 
+    const bool nodeShared = nodeSharedGather && (sz>1);
+    if (nodeShared)
+      initializeNodeSharedGrid(lg,localParams,alwaysInitializeGrid);
+    else if ((alwaysInitializeGrid)||(!lg.isInitialized())) 
       lg.initialize(localParams);
 	
     lg.setName(dataName.c_str());
@@ -1534,6 +1595,21 @@ public:
 	  }
       }
 
+    IT sendReceiveShared[sz][2];
+    if (nodeShared)
+      {
+	// Only node leaders receive, and nothing is exchanged within a node
+	const bool isNodeLeader = mpiCom->isNodeLeader();
+	for (int rk=0;rk<sz;++rk)
+	  {
+	    const bool otherNode = !mpiCom->sameNode(rk);
+	    const bool rkIsLeader = (mpiCom->getNodeLeader(rk)==rk);
+	    sendReceiveShared[rk][0]=(sendReceive[rk][0])&&(otherNode)&&(rkIsLeader);
+	    sendReceiveShared[rk][1]=(sendReceive[rk][1])&&(otherNode)&&(isNodeLeader);
+	  }
+	sendReceive=sendReceiveShared;
+      }
+
     int res[NDIM];    
     std::copy_n(params.resolution,NDIM,res);
 
@@ -1618,6 +1694,23 @@ public:
     for (int i=0;i<sz;++i) 
       if (receiveCount[i]!=0) 
 	MPI_Type_free(&receiveType[i]);
+
+    if (nodeShared)
+      {
+	// Each process copies its own part to the shared grid
+	const int rank=mpiCom->rank();
+	int iMax[NDIM];
+	for (int j=0;j<NDIM;++j) iMax[j]=pos[rank][j]+subDim[rank][j];
+
+	for (int f=0;f<getNFields();++f)
+	  {
+	    typename LocalGrid::oneFieldIterator itOut(lg.subbox_begin(pos[rank],iMax),f); 
+	    local_oneFieldIterator itIn(grid->begin(),f);
+	    const local_oneFieldIterator itIn_end(grid->end(),f);
+	    std::copy(itIn,itIn_end,itOut);
+	  }
+	mpiCom->syncNodeShared(nodeSharedWin);
+      }
   }
 
   void gatherAll(LocalGrid &lg, bool alwaysInitializeGrid=false)
@@ -1783,6 +1876,27 @@ public:
 
 private:
 
+  // (Re)allocate the node shared buffer if needed and make lg use it
+  void initializeNodeSharedGrid(LocalGrid &lg, const Params &localParams, 
+				bool alwaysInitializeGrid)
+  {
+    long nValues=localParams.nFields;
+    for (int i=0;i<NDIM;++i) nValues*=valueCoord[i].size();
+    nValues=std::max(nValues,static_cast<long>(localParams.minElementsCount));
+
+    if (nValues>nodeSharedSize)
+      {
+	if (nodeSharedPtr!=NULL) mpiCom->freeNodeShared(&nodeSharedWin);
+	nodeSharedPtr=mpiCom->allocateNodeShared(nValues*sizeof(Data),&nodeSharedWin);
+	nodeSharedSize=nValues;
+	alwaysInitializeGrid=true;
+      }
+
+    if ((alwaysInitializeGrid)||(!lg.isInitialized())||
+	(static_cast<void*>(lg.getDataPtr())!=nodeSharedPtr))
+      lg.initialize(localParams,static_cast<Data*>(nodeSharedPtr));
+  }
+
   template <class AMR, class T>
   void addAmrGrid_getParams(int index, T pos[NDIM], T resolution[NDIM], T &level)
   {
@@ -1880,6 +1994,11 @@ private:
   //std::vector<int> remoteGridPos[NDIM];
   std::vector<RemoteData> remoteData;
   GridTopology topology;
+
+  bool nodeSharedGather;
+  MPI_Win nodeSharedWin;
+  void *nodeSharedPtr;
+  long nodeSharedSize;
 };
 
 /** \}*/
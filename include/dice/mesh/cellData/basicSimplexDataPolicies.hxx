@@ -1,6 +1,8 @@
 #ifndef __BASIC_SIMPLEX_DATA_POLICIES_HXX__
 #define __BASIC_SIMPLEX_DATA_POLICIES_HXX__
 
+#include <algorithm>
+
 
 #include "../../internal/namespace.header"
 
@@ -447,5 +449,143 @@ namespace simplexCoarsenDataPolicy {
 
 }
 
+namespace simplexStorageDataPolicy {
+
+  // Values are stored as is, there is no conversion overhead
+  template <typename T, int N>
+  struct Native
+  {
+    typedef T Storage;
+    static const bool IS_NATIVE=true;
+
+    static T* getWriteBuffer(Storage *value, T *tmp)
+    {
+      return value;
+    }
+
+    template <class M, class S>
+    static T* getReadWriteBuffer(Storage *value, T *tmp, const M *mesh, const S *simplex)
+    {
+      return value;
+    }
+
+    template <class M, class S>
+    static void commit(Storage *value, const T *result, const M *mesh, const S *simplex)
+    {}
+
+    template <class M, class S>
+    static void encode(Storage *value, const T *val, const M *mesh, const S *simplex)
+    {
+      std::copy_n(val,N,value);
+    }
+
+    template <class M, class S>
+    static void decode(const Storage *value, T *result, const M *mesh, const S *simplex)
+    {
+      std::copy_n(value,N,result);
+    }
+
+    template <class M, class S>
+    static T decodeAt(const Storage *value, int at, const M *mesh, const S *simplex)
+    {
+      return value[at];
+    }
+  };
+
+  // Per-segment coordinates (i.e. N=S::NSEG*S::NDIM_W, such as segment tracers)
+  // stored in single precision as offsets relative to the midpoint of their 
+  // segment. Values are upcasted to T when decoded. Note that the stored values
+  // depend on the coordinates of the vertices, so they have to be re-encoded 
+  // whenever the vertices are moved.
+  template <typename T, int N>
+  struct SegmentMidpointOffset
+  {
+    typedef float Storage;
+    static const bool IS_NATIVE=false;
+
+    static T* getWriteBuffer(Storage *value, T *tmp)
+    {
+      return tmp;
+    }
+
+    template <class M, class S>
+    static T* getReadWriteBuffer(Storage *value, T *tmp, const M *mesh, const S *simplex)
+    {
+      decode(value,tmp,mesh,simplex);
+      return tmp;
+    }
+
+    template <class M, class S>
+    static void commit(Storage *value, const T *result, const M *mesh, const S *simplex)
+    {
+      encode(value,result,mesh,simplex);
+    }
+
+    template <class M, class S>
+    static void encode(Storage *value, const T *val, const M *mesh, const S *simplex)
+    {
+      static_assert(N==S::NSEG*S::NDIM_W,
+		    "SegmentMidpointOffset requires one coordinate per segment");
+      T mid[S::NDIM_W];
+      for (int i=0;i<S::NSEG;++i)
+	{
+	  getMidPoint(mesh,simplex,i,mid);
+	  const T *v = &val[S::NDIM_W*i];
+	  Storage *res = &value[S::NDIM_W*i];
+	  for (int j=0;j<S::NDIM_W;++j)
+	    res[j]=static_cast<Storage>
+	      (mesh->getGeometry()->checkCoordConsistency(v[j],mid[j],j)-mid[j]);
+	}
+    }
+
+    template <class M, class S>
+    static void decode(const Storage *value, T *result, const M *mesh, const S *simplex)
+    {
+      static_assert(N==S::NSEG*S::NDIM_W,
+		    "SegmentMidpointOffset requires one coordinate per segment");
+      for (int i=0;i<S::NSEG;++i)
+	decodeSegment(value,i,&result[S::NDIM_W*i],mesh,simplex);
+    }
+
+    template <class M, class S>
+    static T decodeAt(const Storage *value, int at, const M *mesh, const S *simplex)
+    {
+      T res[S::NDIM_W];
+      decodeSegment(value,at/S::NDIM_W,res,mesh,simplex);
+      return res[at%S::NDIM_W];
+    }
+
+  private:
+    template <class M, class S>
+    static void getMidPoint(const M *mesh, const S *simplex, int i, T *mid)
+    {
+      typedef typename S::Coord Coord;
+      const typename S::SegmentHandle sh=const_cast<S*>(simplex)->getSegmentHandle(i);
+      const Coord *c0=sh->getVertex(0)->getCoordsConstPtr();
+      const Coord *c1=sh->getVertex(1)->getCoordsConstPtr();
+
+      std::copy_n(c0,S::NDIM_W,mid);
+      for (int j=0;j<S::NDIM_W;++j)
+	{
+	  mid[j] += mesh->getGeometry()->checkCoordConsistency(c1[j],c0[j],j);
+	  mid[j] *= 0.5;
+	}
+      mesh->getGeometry()->checkBoundary(mid);
+    }
+
+    template <class M, class S>
+    static void decodeSegment(const Storage *value, int i, T *result, 
+			      const M *mesh, const S *simplex)
+    {
+      const Storage *val = &value[S::NDIM_W*i];
+      getMidPoint(mesh,simplex,i,result);
+      for (int j=0;j<S::NDIM_W;++j)
+	result[j] += static_cast<T>(val[j]);
+      mesh->getGeometry()->checkBoundary(result);
+    }
+  };
+
+}
+
 #include "../../internal/namespace.footer"
 #endif
@@ -43,9 +43,9 @@ namespace cellDataFunctors {
       dataInfo(Cell::template DeclaredCellData<W>::getDataInfo())
     {}
     double get(const Cell *c) const
-    {return (double)c->template getDataElementPtr<W>()->getValue();}
+    {return (double)c->template getDataElementPtr<W>()->getValueAt(0,Base::mesh,c);}
     double get(const Cell *c, int n) const
-    {return (double)c->template getDataElementPtr<W>()->getValueAt(n);}
+    {return (double)c->template getDataElementPtr<W>()->getValueAt(n,Base::mesh,c);}
     std::string getName() const {return dataInfo.name;}
     int getSize() const {return Cell::template DeclaredCellData<W>::Result::SIZE;}
   private:
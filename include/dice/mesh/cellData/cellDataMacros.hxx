@@ -218,7 +218,7 @@ namespace cellDataMacroDetails
   template <class MT, template <int> class TL,int W>
   static void createDataElementsMpiStructType(MpiDataType &mpiDataType,hlp::IsTrue)
   {
-    mpiDataType.push_back<typename TL<W>::Result::Type>
+    mpiDataType.push_back<typename TL<W>::Result::Storage>
       (TL<W>::Result::SIZE,MT::template DeclaredCellData<W>::offset);
    
     typedef typename hlp::IsTrueT< (TL<W+1>::Result::SIZE > 0) >::Result Status;
@@ -319,8 +319,10 @@ namespace cellDataMacroDetails
     for (int i=0;i<nSimplices;++i)
       {
 	// First copy the value in the cell before splitting into refdata
+	// NB: this is the raw storage upcasted to Data for non-native storage
 	Data refData[CellDataW::SIZE];
-	const Data *dataPtr = s0[i]->template getDataElementPtr<W>()->getPointer();
+	const typename CellDataW::Storage *dataPtr = 
+	  s0[i]->template getDataElementPtr<W>()->getConstPointer();
 	std::copy(dataPtr,dataPtr+CellDataW::SIZE,refData);
 
 	// And then compute the new values in the two daughter cells
@@ -358,8 +360,10 @@ namespace cellDataMacroDetails
     for (int i=0;i<nSimplices;++i)
       {
 	// First copy the value in the cell before splitting into refdata
+	// NB: this is the raw storage upcasted to Data for non-native storage
 	Data refData[CellDataW::SIZE];
-	const Data *dataPtr = s0[i]->template getDataElementPtr<W>()->getPointer();
+	const typename CellDataW::Storage *dataPtr = 
+	  s0[i]->template getDataElementPtr<W>()->getConstPointer();
 	std::copy(dataPtr,dataPtr+CellDataW::SIZE,refData);
 
 	// And then compute the new values in the two daughter cells
@@ -397,7 +401,7 @@ namespace cellDataMacroDetails
 			       const V *removeVertex, hlp::IsTrue)
   {    
     keep->template getDataElementPtr<W>()->coarsen
-      (remove->template getDataElementPtr<W>()->getPointer());
+      (mesh,keep,remove->template getDataElementPtr<W>(),remove);
     typedef typename hlp::IsTrueT< (TL<W+1>::Result::SIZE > 0) >::Result Status;
     onCoarsenSimplex<TL,M,S,V,W+1>(mesh,keep,keepVertexIndex,removeIndex,remove,
 				   removeVertexIndex,keepIndex,removeVertex,Status());
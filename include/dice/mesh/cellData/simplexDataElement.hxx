@@ -13,37 +13,53 @@ template <int ID, int N, typename T = double,
 	  simplexRefineDataPolicy::Dummy,
 	  template <typename,int> class OnCoarsenPolicy = 
 	  simplexCoarsenDataPolicy::Dummy,
-	  bool OutputOnDump = true>
+	  bool OutputOnDump = true,
+	  template <typename,int> class StoragePolicy = 
+	  simplexStorageDataPolicy::Native>
 class SimplexDataElementT
 {
 public:  
   typedef T Type;
-  typedef SimplexDataElementT<ID,N,T,OnInitPolicy,OnRefinePolicy,OnCoarsenPolicy,OutputOnDump> MyType;
+  typedef StoragePolicy<T,N> Storer;
+  typedef typename Storer::Storage Storage;
+  typedef SimplexDataElementT<ID,N,T,OnInitPolicy,OnRefinePolicy,OnCoarsenPolicy,
+			      OutputOnDump,StoragePolicy> MyType;
   static const int SIZE = N;
   static const int INDEX = ID;
   static const bool OUTPUT_ON_DUMP=OutputOnDump;
+  static const bool NATIVE_STORAGE=Storer::IS_NATIVE;
   //static const bool CREATE_FUNCTOR=CreateFunctor;
   //static const size_t OFFSET; // Value is attributed through DECLARE_CELL_DATA_ELEMENT macro
-  T value[N];
+  Storage value[N];
 
   template <class M, class S, class DT>
   void init(const M *mesh, const S* simplex, const DT* initVal)
   {
-    OnInitPolicy<T,N,M,S,DT>::init(value, mesh, simplex, initVal);
+    T tmp[N];
+    T *result=Storer::getWriteBuffer(value,tmp);
+    OnInitPolicy<T,N,M,S,DT>::init(result, mesh, simplex, initVal);
+    Storer::commit(value,result,mesh,simplex);
   }
 
   template <class M, class S>
   void init(const M *mesh, const S* simplex)
   {
-    OnInitPolicy<T,N,M,S,T>::init(value, mesh, simplex, static_cast<T*>(NULL));
+    T tmp[N];
+    T *result=Storer::getWriteBuffer(value,tmp);
+    OnInitPolicy<T,N,M,S,T>::init(result, mesh, simplex, static_cast<T*>(NULL));
+    Storer::commit(value,result,mesh,simplex);
   }
   
   template <int PASS, class M, class V, class S>
   void refine(const M *mesh, const V* newVertex, const S* simplex, const S* otherSimplex,
 	      T* refValue, void *buffer)
   {    
+    // Some policies only update part of the values
+    T tmp[N];
+    T *result=Storer::getReadWriteBuffer(value,tmp,mesh,simplex);
     OnRefinePolicy<PASS,T,N,M,V,S>::refine
-      (value,mesh,newVertex,simplex,otherSimplex,refValue,buffer);
+      (result,mesh,newVertex,simplex,otherSimplex,refValue,buffer);
+    Storer::commit(value,result,mesh,simplex);
   }
 
   void coarsen(T *rmValue)
@@ -51,13 +67,47 @@ public:
     OnCoarsenPolicy<T,N>::coarsen(value,rmValue);
   }
 
-  T* getPointer() {return value;}
-  const T* getConstPointer() const {return value;}
+  template <class M, class S>
+  void coarsen(const M *mesh, const S* simplex, MyType *rm, const S* rmSimplex)
+  {
+    T keepTmp[N];
+    T rmTmp[N];
+    T *keepValue=Storer::getReadWriteBuffer(value,keepTmp,mesh,simplex);
+    T *rmValue=Storer::getReadWriteBuffer(rm->value,rmTmp,mesh,rmSimplex);
+    OnCoarsenPolicy<T,N>::coarsen(keepValue,rmValue);
+    Storer::commit(value,keepValue,mesh,simplex);
+  }
+
+  // Decode the stored values to their full precision representation in 'result'.
+  // With native storage, this is a simple copy.
+  template <class M, class S>
+  void get(const M *mesh, const S* simplex, T *result) const
+  {
+    Storer::decode(value,result,mesh,simplex);
+  }
+
+  // Encode full precision values 'val' into the storage
+  template <class M, class S>
+  void set(const M *mesh, const S* simplex, const T *val)
+  {
+    Storer::encode(value,val,mesh,simplex);
+  }
+
+  // NB: with non-native storage, these return the raw storage
+  Storage* getPointer() {return value;}
+  const Storage* getConstPointer() const {return value;}
 
   void setValue(T val) {value[0]=val;}
   void setValueAt(T val, int at) {value[at]=val;}
   T  getValue() const {return value[0];}
   T  getValueAt(int at) const {return value[at];} 
+
+  template <class M, class S>
+  T getValueAt(int at, const M *mesh, const S* simplex) const
+  {
+    return Storer::decodeAt(value,at,mesh,simplex);
+  }
+
   static int getSize() {return SIZE;}
   
   template <class WR>
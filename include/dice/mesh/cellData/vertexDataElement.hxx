@@ -16,6 +16,7 @@ class VertexDataElementT
 {
 public:    
   typedef T Type;
+  typedef T Storage;
   typedef VertexDataElementT<ID,N,T,OnInitPolicy,OnRefinePolicy,OutputOnDump> MyType;
   static const int SIZE = N;
   static const int INDEX = ID;
@@ -93,17 +93,17 @@ public:
   typedef typename Simplex::Ghost         GhostSimplex;
   typedef typename Vertex::Ghost          GhostVertex;
 
-  typedef IterableMemoryPoolT<Simplex,iteratorThreadModel::SortedBlocks> 
+  typedef IterableMemoryPoolT<Simplex,iteratorThreadModel::DynamicChunks> 
   SimplexPool;  
-  typedef IterableMemoryPoolT<Vertex,iteratorThreadModel::SortedBlocks>        
+  typedef IterableMemoryPoolT<Vertex,iteratorThreadModel::DynamicChunks>        
   VertexPool;
-  typedef IterableMemoryPoolT<GhostSimplex,iteratorThreadModel::SortedBlocks>  
+  typedef IterableMemoryPoolT<GhostSimplex,iteratorThreadModel::DynamicChunks>  
   GhostSimplexPool;
-  typedef IterableMemoryPoolT<GhostVertex,iteratorThreadModel::SortedBlocks>   
+  typedef IterableMemoryPoolT<GhostVertex,iteratorThreadModel::DynamicChunks>   
   GhostVertexPool;
-  typedef IterableMemoryPoolT<ShadowSimplex,iteratorThreadModel::SortedBlocks> 
+  typedef IterableMemoryPoolT<ShadowSimplex,iteratorThreadModel::DynamicChunks> 
   ShadowSimplexPool; 
-  typedef IterableMemoryPoolT<ShadowVertex,iteratorThreadModel::SortedBlocks>  
+  typedef IterableMemoryPoolT<ShadowVertex,iteratorThreadModel::DynamicChunks>  
   ShadowVertexPool;
 
   typedef typename VertexPool::UnserializedPointerUpdater        UVPUpdater;
@@ -252,7 +252,7 @@ protected:
 	  (*it)->updateAfterUnserialized(*vpu,*gvpu,*svpu,*spu,*gspu,*sspu,swap);	 
       } 
 
-    Tree::defrag(spu);
+    Tree::defrag(spu,simplexBegin(),simplexEnd());
   }
 
   void construct()
@@ -297,6 +297,7 @@ protected:
     shadowSimplexPool.setAllocFactor(params.allocFactor);
     shadowVertexPool.setAllocFactor(params.allocFactor);
     Tree::setAllocFactor(params.allocFactor);
+    Tree::setTreeFree(params.treeFree);
 
     if (geometry != NULL) delete geometry;
     geometry = new GeometricProperties(&params.x0[0],&params.delta[0]);	
@@ -367,7 +368,7 @@ protected:
       } 
     glb::console->printFlush<LOG_INFO>("done.\n");
 
-    Tree::build(reader,spu);
+    Tree::build(reader,spu,simplexBegin(),simplexEnd());
   }
 
 public:
@@ -577,6 +578,7 @@ public:
 		      int nThreads=glb::num_omp_threads)
   {
     if (nThreads<1) nThreads=omp_get_max_threads();
+    prepareSimplexThreadIteration(nThreads,visitLocals,visitGhosts,visitShadows);
     if (visitLocals)
       {
 #pragma omp parallel for num_threads(nThreads)
@@ -627,6 +629,7 @@ public:
 		     int nThreads=glb::num_omp_threads)
   {
     if (nThreads<1) nThreads=omp_get_max_threads();
+    prepareVertexThreadIteration(nThreads,visitLocals,visitGhosts,visitShadows);
     if (visitLocals)
       {
 #pragma omp parallel for num_threads(nThreads)
@@ -1710,7 +1713,9 @@ protected:
       
     vertexPool.reserve(refinedSegments.size());
     simplexPool.reserve(nSimplicesCum.back());
-    Tree::nodePool.reserve(nSimplicesCum.back());    
+    // no tree node is needed in tree free mode, NULL nodes are passed to splitSegment
+    const bool treeFree=Tree::isTreeFree();
+    if (!treeFree) Tree::nodePool.reserve(nSimplicesCum.back());    
 
     std::vector<Coord> dummyCoord(NDIM_W,0);
     for (unsigned long i=0;i<refinedSegments.size();i++)
@@ -1749,7 +1754,8 @@ protected:
 	    simplexPool.pop(&s);
 	    s->setLocalIndex(getNCells(NDIM)-1);
 	    newSimplices.push_back(s);
-	    Tree::nodePool.pop(&n);
+	    if (treeFree) n=NULL;
+	    else Tree::nodePool.pop(&n);
 	    newNodes.push_back(n);	    
 	  }	
       }
@@ -1836,8 +1842,8 @@ protected:
 	//solver->onRefineSimplices(h,v,lst,s,nSimplices);
       }
     
-    // FIXME: getRoot is ~log(N) where N is the number of simplices ...
-    // We do it here because it is not thread safe !
+    // FIXME: getRoot is ~log(N) where N is the number of simplices (but O(1) in tree
+    // free mode) ... We do it here because it is not thread safe !
     for (TT i=0;i<nSimplicesCum.back();i++)
       newSimplices[i]->getRoot()->increaseWeight();
 
@@ -2404,6 +2410,33 @@ public:
   typedef UnionIterator2T<const_vertexPtr_iterator,
 			  const_ghostVertexPtr_iterator> const_vertexPtr_LG_iterator;
   
+  /** \brief Prepares the simplex pools for a threaded iteration with \a stride iterators 
+   *  (i.e. simplexBegin(i,stride), simplexLGBegin(i,stride), ... for i in [0,stride[). 
+   *  The iterators will then dynamically claim chunks of simplices instead of being given
+   *  a static share of the pools, which balances the load when the cost per simplex varies.
+   *  Must be called outside of the parallel region, and each iterator must be iterated
+   *  until its end. See FOREACH_THREAD_SIMPLEX macros in meshIteratorsMacros.hxx.
+   */
+  void prepareSimplexThreadIteration(int stride, bool locals=true, 
+				     bool ghosts=false, bool shadows=false)
+  {
+    if (stride<2) return;
+    if (locals) simplexPool.prepareThreadIteration(stride);
+    if (ghosts) ghostSimplexPool.prepareThreadIteration(stride);
+    if (shadows) shadowSimplexPool.prepareThreadIteration(stride);
+  }
+
+  /** \brief Same as prepareSimplexThreadIteration() for the vertex pools
+   */
+  void prepareVertexThreadIteration(int stride, bool locals=true, 
+				    bool ghosts=false, bool shadows=false)
+  {
+    if (stride<2) return;
+    if (locals) vertexPool.prepareThreadIteration(stride);
+    if (ghosts) ghostVertexPool.prepareThreadIteration(stride);
+    if (shadows) shadowVertexPool.prepareThreadIteration(stride);
+  }
+
   simplexPtr_iterator simplexBegin(int delta=0, int stride=1)
   {
     if (stride<2)
@@ -2,6 +2,7 @@
 #define __MESH_HXX__
 
 #include <set>
+#include <numeric>
 
 #include "../dice_globals.hxx"
 
@@ -26,9 +27,11 @@
 #include "../tools/types/cell.hxx"
 #include "../tools/IO/myIO.hxx"
 #include "../tools/IO/paramsParser.hxx"
+#include "../tools/MPI/mpiChunkedExchange.hxx"
 #include "../tools/helpers/find_unordered_maps.hxx"
 #include "../tools/sort/ompPSort.hxx"
 #include "../tools/sort/peanoHilbert.hxx"
+#include "../tools/memory/scratchArena.hxx"
 
 #include "../IO/ndNetUnstructuredMesh.hxx"
 
@@ -298,6 +301,7 @@ public:
   
     ghostExchange.unSerialize(reader, *spu, *gspu);
     shadowExchange.unSerialize(reader, *spu, *sspu);
+    updateExchangeNeighborhoods();
 
     if (glb::console->willPrint<LOG_INFO>())
       {
@@ -632,70 +636,24 @@ public:
 
   /** \brief Synchronize the value stored in the cache variable of ghost simplices to 
    *  the value stored in the cache variable of their local simplex.   
+   *  Persistent MPI requests are reused from one call to the next as long as the ghost
+   *  layer does not change (see MpiCellDataExchangeT::cacheExchange).
    */
   template <typename CacheT = uint64_t>
   void synchronizeGhostSimplicesCache()
   {        
-    std::vector< std::vector<CacheT> > send(ghostExchange.sendRank.size());
-    std::vector< std::vector<CacheT> > receive;
-
-#pragma omp parallel for
-    for (unsigned long i=0;i<ghostExchange.sendRank.size();i++)
-      {
-	int src = ghostExchange.sendRank[i];
-	send[i].resize(ghostExchange.send[src].size());
-	for (unsigned long j=0;j<send[i].size();j++)
-	  memcpy(&send[i][j],&(ghostExchange.send[src][j]->cache.ui64),sizeof(CacheT));
-	//send[i][j] = ghostExchange.send[src][j]->cache.ui64;
-      }
-    
-    ghostExchange.exchange(send,receive,0);
-    
-#pragma omp parallel for
-    for (unsigned long i=0;i<ghostExchange.receiveRank.size();i++)
-      {
-	int src = ghostExchange.receiveRank[i];
-	for (unsigned long j=0;j<ghostExchange.receive[src].size();j++)
-	  {
-	    GhostSimplex *g=ghostExchange.receive[src][j];
-	    memcpy(&(g->cache.ui64),&receive[i][j],sizeof(CacheT));
-	    //g->cache.ui64 = receive[i][j];
-	  }
-      }			   
+    ghostExchange.template cacheExchange<CacheT>();
   }
   
   /** \brief Synchronize the value stored in the cache variable of shadow simplices to 
    *  the value stored in the cache variable of their local simplex.   
+   *  Persistent MPI requests are reused from one call to the next as long as the shadow
+   *  layer does not change (see MpiCellDataExchangeT::cacheExchange).
    */
   template <typename CacheT = uint64_t>
   void synchronizeShadowSimplicesCache()
   {
-    std::vector< std::vector<CacheT> > send(shadowExchange.sendRank.size());
-    std::vector< std::vector<CacheT> > receive;
-
-#pragma omp parallel for
-    for (unsigned long i=0;i<shadowExchange.sendRank.size();i++)
-      {
-	int src = shadowExchange.sendRank[i];
-	send.resize(shadowExchange.send[src].size());
-	for (unsigned long j=0;j<send[i].size();j++)
-	  memcpy(&send[i][j],&(shadowExchange.send[src][j]->cache.ui64),sizeof(CacheT));
-	//send[i][j] = shadowExchange.send[src][j]->cache.ui64;
-      }
-    
-    shadowExchange.exchange(send,receive,0);
-
-#pragma omp parallel for
-    for (unsigned long i=0;i<shadowExchange.receiveRank.size();i++)
-      {
-	int src = shadowExchange.receiveRank[i];
-	for (unsigned long j=0;j<shadowExchange.receive[src].size();j++)
-	  {
-	    ShadowSimplex *g=shadowExchange.receive[src][j];
-	    memcpy(&(g->cache.ui64),&receive[i][j],sizeof(CacheT));
-	    //g->cache.ui64 = receive[i][j];
-	  }
-      }			   
+    shadowExchange.template cacheExchange<CacheT>();
   }
  
   /** \brief Sort the simplices and vertices of the mesh locally (i.e. independantly on 
@@ -735,6 +693,17 @@ public:
   }
   */
 
+  // default value of the rootPartitioner argument of repart() : use the partitioner
+  // selected by MeshParamsT::refinePartitionType 
+  struct NoRootPartitioner
+  {
+    bool operator()(const std::vector<double> &rootWeights, 
+		    std::vector<PartitionerIndex> &partition)
+    {
+      return false;
+    }
+  };
+
   /** \brief Repartition the mesh in order to improve load balance if needed.
    *
    *  The imbalance is computed as  \f$ i=max_k(weight[k]*nSimplices[k]) / 
@@ -743,6 +712,16 @@ public:
    *  \param weight A relative weight given to the local partition before
    *  computing the load balance. If \a weight is 0, all partitions have the same weight.
    *  \param force if true, forces repartitionning to happen
+   *  \param nThreads the number of threads to use
+   *  \param rootWeights if not NULL, the weight of each root node of the mesh tree
+   *  (indexed by local index, see getRootSums()). The weight of the local partition is 
+   *  then the sum of its roots weight and \a weight is ignored. This lets the 
+   *  partitioner spread the regions that are more expensive to process evenly.
+   *  \param rootPartitioner if not NULL, a functor called as 
+   *  (*rootPartitioner)(rootWeights,partition) when repartitioning is needed, where
+   *  rootWeights is the weight of each root. If it returns true, partition is used as
+   *  the new rank of each root instead of calling the partitioner selected with 
+   *  MeshParamsT::refinePartitionType. It must return the same value on all processes.
    */
   // FIXME : post an Irecv before Isend and use waitall ...
   // FIXME : it would be nice NOT to reallocate a new ghostSimplex pool ...
@@ -750,7 +729,10 @@ public:
   // FIXME : add a function to clean the Queue in memoryPool ?
   // Weight is the weight of this process, if weight<=0, then the weight
   // is given by the number of local cells
-  bool repart(double weight=0, bool force=false, int nThreads=glb::num_omp_threads)
+  template <class RootPartitioner=NoRootPartitioner>
+  bool repart(double weight=0, bool force=false, int nThreads=glb::num_omp_threads,
+	      const std::vector<double> *rootWeights=NULL,
+	      RootPartitioner *rootPartitioner=NULL)
   {    
     typedef typename my_dense_set<Vertex*>::type VertexDenseSet;
     typedef typename VertexDenseSet::iterator VertexDenseSet_it; 
@@ -772,7 +754,17 @@ public:
     double imbalance;
     double weightPerCell;
 
-    if (weight<=0) 
+    if (rootWeights!=NULL)
+      {
+	weight=std::accumulate(rootWeights->begin(),rootWeights->end(),0.0);
+	weightPerCell = weight / LocalMesh::getNCells()[NDIM];
+	
+	auto minMaxSum = mpiCom->minMaxSum(weight);
+	double max=minMaxSum.first.second;
+	double avg=minMaxSum.second / mpiCom->size();
+	imbalance = max/avg;
+      }
+    else if (weight<=0) 
       {
 	weightPerCell=1.0;
 	imbalance = getLoadImbalanceFactor();
@@ -818,13 +810,30 @@ public:
     glb::console->indent();
 
     std::vector<PartitionerIndex> partition;
+    bool presetPartition=false;
+    if (rootPartitioner!=NULL)
+      {
+	std::vector<double> w;
+	if (rootWeights!=NULL) w=*rootWeights;
+	else
+	  {
+	    getRootSums(NULL,w);
+	    for (unsigned long i=0;i<w.size();++i) w[i]*=weightPerCell;
+	  }
+	presetPartition=(*rootPartitioner)(w,partition);
+      }
+
     MpiCellDataExchangeT<Simplex,TreeNode> leavesExchange(mpiCom);
     Tree::repart(partition,
 		 params.refinePartitionType,
 		 params.repartTolerance,
 		 weightPerCell,
 		 leavesExchange,
-		 nThreads);
+		 LocalMesh::simplexBegin(),
+		 LocalMesh::simplexEnd(),
+		 nThreads,
+		 rootWeights,
+		 presetPartition);
 
     // FIXME : show this ?
     //leavesExchange.template print<LOG_DEBUG>("leaves");   
@@ -1127,56 +1136,52 @@ public:
 	  }
       }
 
-     // send the vertices that need to be sent
+    // send the vertices that need to be sent, chunk by chunk so that the
+    // first chunks are on their way while the next ones are being packed
+    typedef RepartChunkPacker<VertexDenseSet_it,MpiExchg_RepartVertices> 
+      VertexPacker;
     std::vector< std::vector<MpiExchg_RepartVertices> > 
       sendVertices(leavesExchange.sendRank.size());
-    requests[3].resize(leavesExchange.sendRank.size());
+    MpiChunkedExchangeT<MpiExchg_RepartVertices> 
+      vertexExchange(mpiCom,mpiType_repartVertices.getType(),
+		     mpiTagsStart_repart+3,leavesExchange.sendRank.size(),
+		     params.repartChunkSize);
 #pragma omp parallel for num_threads(nThreads)
     for (unsigned long i=0;i<leavesExchange.sendRank.size();++i)
       {	
-	sendVertices[i].resize(sendVertexSet[i].size());
-	unsigned long j=0;
-	const VertexDenseSet_it it_end=sendVertexSet[i].end();
-	for (VertexDenseSet_it it=sendVertexSet[i].begin();it!=it_end;++it)
-	  sendVertices[i][j++].set(*it);
+	VertexPacker packer(sendVertexSet[i].begin(),myRank);
+	vertexExchange.send(i,leavesExchange.sendRank[i],sendVertices[i],
+			    sendVertexSet[i].size(),packer);
 
 	// glb::console->print<LOG_DEBUG>("sendVertexSet[%ld]: size = %ld  => %.2g \n",i,
 	// 			       sendVertexSet[i].size(),
 	// 			       double(sendVertexSet[i].size())/
 	// 			       sendVertexSetLoadGuess[i]);
 	sendVertexSet[i].clear();
-
-	mpiCom->IsendMpiType(&sendVertices[i][0],sendVertices[i].size(),
-			     mpiType_repartVertices.getType(),
-			     leavesExchange.sendRank[i],&requests[3][i],
-			     mpiTagsStart_repart+3);
       }    
     
     // and send the new remote ghosts. Meanwhile, we can do some work. 
-    requests[2].resize(leavesExchange.sendRank.size());
+    typedef RepartChunkPacker<SimplexDenseSet_it,MpiExchg_RepartSimplicesWithCache> 
+      GhostPacker;
     std::vector< std::vector<MpiExchg_RepartSimplicesWithCache> > 
       sendGhostSimplices(leavesExchange.sendRank.size());    
+    MpiChunkedExchangeT<MpiExchg_RepartSimplicesWithCache> 
+      ghostExchangeStream(mpiCom,mpiType_repartSimplicesWithCache.getType(),
+			  mpiTagsStart_repart+2,leavesExchange.sendRank.size(),
+			  params.repartChunkSize);
 
 #pragma omp parallel for num_threads(nThreads)
     for (unsigned long i=0;i<leavesExchange.sendRank.size();++i)
       {
-	//mpiCom->wait(&requests[1][i]); // make sure we can clear sendSimplices
-	sendGhostSimplices[i].resize(newGhostSimplices[i].size());
-	unsigned long j=0;
-	const SimplexDenseSet_it it_end=newGhostSimplices[i].end();
-	for (SimplexDenseSet_it it=newGhostSimplices[i].begin();it!=it_end;++it)
-	  sendGhostSimplices[i][j++].set(*it,myRank);
+	GhostPacker packer(newGhostSimplices[i].begin(),myRank);
+	ghostExchangeStream.send(i,leavesExchange.sendRank[i],sendGhostSimplices[i],
+				 newGhostSimplices[i].size(),packer);
 	
 	// glb::console->print<LOG_DEBUG>("newGhostSimplices[%ld]: size = %ld  => %.2g \n",i,
 	// 			       newGhostSimplices[i].size(),
 	// 			       double(newGhostSimplices[i].size())/
 	// 			       newGhostSimplicesLoadGuess[i]);
 	newGhostSimplices[i].clear(); //don't need that anymore !
-
-	mpiCom->IsendMpiType(&sendGhostSimplices[i][0],sendGhostSimplices[i].size(),
-			     mpiType_repartSimplicesWithCache.getType(),
-			     leavesExchange.sendRank[i],&requests[2][i],
-			     mpiTagsStart_repart+2);
       }
          
     // the new ghosts that are already local need to be serialized as 
@@ -1307,6 +1312,10 @@ public:
 	  	  
       }
 
+    // give MPI a chance to progress the transfers posted above (this does nothing
+    // if a progress thread is already taking care of it)
+    mpiCom->progress();
+
     // We must not forget to recycle allocated vertexBalls before destroying the pool
     for (unsigned long i=0;i<vertexBallArr.size();++i)
       if (vertexBallArr[i]!=NULL)
@@ -1336,6 +1345,8 @@ public:
 	  }	  
       }
 
+    mpiCom->progress();
+
     // time to receive the new simplices that were sent earlier
     // we do it with Isend/Ireceive earlier
     mpiCom->Waitall(receivedSimplicesRequests);
@@ -1395,34 +1406,10 @@ public:
     std::vector< std::vector<MpiExchg_RepartSimplicesWithCache> > 
       receivedGhostSimplices(leavesExchange.receiveRank.size());
 
-    for (unsigned long i=0;i<leavesExchange.receiveRank.size();++i)
-      {	
-	int count=0;
-	int source=mpiCom->ProbeCount(count,mpiType_repartSimplicesWithCache.getType(),
-				      mpiTagsStart_repart+2);
-	int srcIndex=receiveRankIndex[source];
-
-	if (count>0) receivedGhostSimplices[srcIndex].resize(count);
-	else receivedGhostSimplices[srcIndex].clear();
-	  
-	mpiCom->RecvMpiType(&receivedGhostSimplices[srcIndex][0],count,
-			    mpiType_repartSimplicesWithCache.getType(),source,
-			    mpiTagsStart_repart+2);
-	
-	for (int j=0;j<count;++j)
-	  {	    
-	    GlobalIdentityValue gid=receivedGhostSimplices[srcIndex][j].gid;
-	    const SimplexDenseHash_it it=simplicesHash.find(gid);
-	    if (it==simplicesHash.end())
-	      {
-		GhostSimplex *gSimplex;
-		newGhostSimplexPool.pop(&gSimplex);
-		gSimplex->setData(receivedGhostSimplices[srcIndex][j].sData);
-		gSimplex->setGeneration(receivedGhostSimplices[srcIndex][j].generation);
-		simplicesHash.insert(std::make_pair(gid,gSimplex));
-	      }
-	  }	
-      }  
+    RepartGhostUnpacker<SimplexDenseHash,typename LocalMesh::GhostSimplexPool>
+      ghostUnpacker(receivedGhostSimplices,receiveRankIndex,
+		    simplicesHash,newGhostSimplexPool);
+    ghostExchangeStream.receive(leavesExchange.receiveRank.size(),ghostUnpacker);
    
     // the already local vertices will be either rebuilt if they are ghosts/shadow
     // or conserved if not
@@ -1465,33 +1452,12 @@ public:
    
     // Here only the local vertices that remained local are in the pool, and their shared
     // flags have been wiped -> receive the new vertices !
-    for (unsigned long i=0;i<leavesExchange.receiveRank.size();++i)
-      {	
-	int count=0;
-	int source=mpiCom->ProbeCount(count,mpiType_repartVertices.getType(),
-				      mpiTagsStart_repart+3);	
-	//int srcIndex=receiveRankIndex[source];
-	std::vector<MpiExchg_RepartVertices> receivedVertices(count);		
-	mpiCom->RecvMpiType(&receivedVertices[0],
-			    receivedVertices.size(),
-			    mpiType_repartVertices.getType(),source,
-			    mpiTagsStart_repart+3);
-	for (unsigned long j=0;j<receivedVertices.size();++j)
-	  {   
-	    MpiExchg_RepartVertices &mpiVertex=receivedVertices[j];
-	    if (verticesHash.find(mpiVertex.gid)==verticesHash.end())
-	      {
-		Vertex *vertex;
-		LocalMesh::vertexPool.pop(&vertex);
-		verticesHash.insert(std::make_pair(mpiVertex.gid,vertex));
-		vertex->setCoords(mpiVertex.coords);	
-		vertex->setData(mpiVertex.vData);	
-		vertex->setGlobalIdentity(mpiVertex.gid);
-		vertex->setGeneration(mpiVertex.generation);
-		vertex->setSetF();	
-	      }
-	  }
-      } 
+    // The chunks are unpacked as they arrive, whatever their source.
+    {
+      RepartVertexUnpacker<VertexDenseHash,typename LocalMesh::VertexPool>
+	vertexUnpacker(verticesHash,LocalMesh::vertexPool);
+      vertexExchange.receive(leavesExchange.receiveRank.size(),vertexUnpacker);
+    }
 
     // and create the vertices we are missing !
      for (unsigned long i=0;i<newLocalVertices.size();++i)
@@ -1890,6 +1856,7 @@ public:
       }
  
     ghostExchange.updateNCum();   
+    ghostExchange.updateNeighborhood();
     // We can now update the local vertices global IDs (this is already done for simplices)
     for (vertexPtr_iterator it=LocalMesh::vertexBegin();it!=itv_end;++it)
       it->setGlobalIdentity(myRank,it->getLocalIndex());      
@@ -2250,11 +2217,14 @@ public:
     for (unsigned long i=0;i<requests.size();i++)
       for (unsigned long j=0;j<requests[i].size();j++)
 	mpiCom->Wait(&requests[i][j]);
+    vertexExchange.wait();
+    ghostExchangeStream.wait();
 
     mpiCom->barrier();
    
     // and update shadowExchange ...
     shadowExchange.updateNCum();
+    shadowExchange.updateNeighborhood();
 
     // We are now DONE !!!!
     // clean-up a little bit before leaving.
@@ -2387,16 +2357,68 @@ public:
     */
   }
 
+  /** \brief Sum a value defined over the local simplices for each root node of the 
+   *  mesh tree. Roots are only modified by repart(), so the result remains valid 
+   *  after refining or coarsening the mesh, and can be used as weights for repart(). 
+   *  \param simplexValues the value of each local simplex (indexed by local index), 
+   *  or NULL to count the simplices descending from each root.
+   *  \param[out] rootValues the sum for each root (indexed by local index)
+   */
+  void getRootSums(const std::vector<double> *simplexValues,
+		   std::vector<double> &rootValues)
+  {
+    rootValues.assign(Tree::getNRootNodes(),0);
+    const simplexPtr_iterator it_end=LocalMesh::simplexEnd();
+    for (simplexPtr_iterator it=LocalMesh::simplexBegin();it!=it_end;++it)
+      {
+	Simplex *simplex=(*it);
+	rootValues[simplex->getRoot()->getLocalIndex()] += (simplexValues==NULL)?
+	  1.0:(*simplexValues)[simplex->getLocalIndex()];
+      }
+  }
+
+  /** \brief Compute a key for each root node of the mesh tree as the smallest key 
+   *  of the local simplices descending from it. With a key defined along a space 
+   *  filling curve, sorting the roots by key orders them along the curve.
+   *  \param sf A functor taking a Simplex* as argument and returning a key of type
+   *  K comparable with operator<(..) (e.g. the functor passed to sort()).
+   *  \param[out] rootKeys the key of each root (indexed by local index)
+   */
+  template <class SimplexFunctor, class K>
+  void getRootKeys(const SimplexFunctor &sf, std::vector<K> &rootKeys)
+  {
+    const unsigned long nRoots=Tree::getNRootNodes();
+    std::vector<char> set(nRoots,0);
+    rootKeys.resize(nRoots);
+    const simplexPtr_iterator it_end=LocalMesh::simplexEnd();
+    for (simplexPtr_iterator it=LocalMesh::simplexBegin();it!=it_end;++it)
+      {
+	Simplex *simplex=(*it);
+	const long id=simplex->getRoot()->getLocalIndex();
+	K key=sf(simplex);
+	if ((!set[id])||(key<rootKeys[id]))
+	  {
+	    rootKeys[id]=key;
+	    set[id]=1;
+	  }
+      }
+  }
+
   /** \brief Adaptively refine the mesh by splitting segments where needed.
    *   
    * This function calls 
    *  \verbatim
-      double solver->checkRefine_getValue(Simplex *s) 
+      template <class S> 
+      void solver->checkRefine_getValues(S * const *s, long n, double *value) 
       \endverbatim
-   * once for each simplex and ghost simplex in the mesh. For each of them, 
-   * checkRefine_getValue should return a double precision number representing how much 
-   * the simplex needs to be refined (negative or null values stand for no refinement 
-   * needed). If the simplex needs refinement, another function 
+   * on consecutive batches of at most CHECK_REFINE_BATCH_SIZE simplices or ghost 
+   * simplices so that every simplex in the mesh is evaluated once. For each of them, 
+   * checkRefine_getValues should set value[i] to a double precision number representing 
+   * how much simplex s[i] needs to be refined (negative or null values stand for no 
+   * refinement needed). Evaluating a whole batch at once lets the solver gather the 
+   * coordinates it needs into contiguous arrays and use vectorized kernels (see
+   * slv::refine::poincareInvariantWithSegTracers_order1_batch).
+   * If the simplex needs refinement, another function 
    * \verbatim
      int checkRefine_getSplitSegmentIndex(Simplex*,double&) 
      \endverbatim
@@ -2409,8 +2431,19 @@ public:
    * recursively and as many passes as needed are executed so that all simplices 
    * have a score <= 0 when the function returns.
    *
+   * The solver must also implement 
+   * \verbatim
+     bool checkRefine_predefinedOrder()
+     \endverbatim
+   * which returns true when checkRefine_getSplitSegmentIndex selects segments 
+   * following a predefined bisection order that does not depend on the score (e.g. 
+   * slv::refine::predefinedBisectionSegment). In that case, a segment is only split
+   * when it is also the segment that every local simplex incident to it would split, 
+   * the incident simplices being refined first otherwise (see 
+   * checkRefine_predefinedOrderClosure). This keeps the shape of the simplices bounded.
+   *
    * \param solver a pointer to an object implementing a function 
-   * checkRefine_getValue and checkRefine_getSplitSegmentIndex. See description hereabove
+   * checkRefine_getValues and checkRefine_getSplitSegmentIndex. See description hereabove
    * for more information.
    * \param nThreads how many openMP threads to use in parallel.
    * \param nPassMax The maximum number of passes to attempt before giving up. Set nPassMax
@@ -2430,11 +2463,20 @@ public:
 
     std::vector<char> check;    
     typedef std::pair<double,SegmentHandle> CandidateSegment;
+    typedef typename ScratchVectorT<CandidateSegment>::Type CandidateVector;
+    typedef typename CandidateVector::iterator candidate_iterator;
+    typedef typename ScratchVectorT<Simplex*>::Type CancelledVector;
     
     if (nThreads<1) nThreads=glb::num_omp_threads;
     std::vector<std::vector<Simplex *> > cachedCandidateSimplices(nThreads);
     std::vector<std::vector<GhostSimplex *> > cachedCandidateGSimplices(nThreads);
     bool useCachedCandidates=false;
+    // Per thread candidates and cancelled simplices, reused by each pass
+    std::vector<CandidateVector> toRefineThread(nThreads);
+    std::vector<CancelledVector> cancelledThread(nThreads);
+    // Simplices whose cache was modified during a pass and that must be reset for the 
+    // next one when using cached candidates.
+    std::vector<CancelledVector> touchedThread(nThreads);
 
     if (glb::debugMeshRefine)
       {
@@ -2460,14 +2502,22 @@ public:
 				    cachedCandidateGSimplices,
 				    useCachedCandidates);
 
+      if (solver->checkRefine_predefinedOrder())
+	{
+	  long nDeferred=checkRefine_predefinedOrderClosure(solver,nThreads,
+							    cachedCandidateSimplices);
+	  glb::console->printFlush<LOG_PEDANTIC>("(closure:%ld) ",nDeferred);
+	}
+
       glb::console->printFlush<LOG_PEDANTIC>("(cflct1) ");
       
-      typedef std::vector<CandidateSegment> CandidateVector;
-      typedef typename CandidateVector::iterator candidate_iterator;
       //CandidateVector toRefineThread[nThreads];
       //std::vector<Simplex*> cancelledThread[nThreads];
-      std::vector<CandidateVector> toRefineThread(nThreads);
-      std::vector< std::vector<Simplex*> > cancelledThread(nThreads);
+      for (long th=0;th<nThreads;th++)
+	{
+	  toRefineThread[th].clear();
+	  cancelledThread[th].clear();
+	}
       
       // Build a list of segments to refine.
       // Also ensure that any simplex that needs refinement is not also refined
@@ -2476,9 +2526,10 @@ public:
 #pragma omp parallel for num_threads(nThreads)
       for (long th=0;th<nThreads;th++)
 	{
-	  if (false)//useCachedCandidates)
+	  if (useCachedCandidates)
 	    {
-	      //FIXME: This does not work
+	      // Only simplices with a positive score may be refined, and any other
+	      // simplex has a NULL cache (see the end of the pass)
 	      const auto it_end=cachedCandidateSimplices[th].end();
 	      for (auto it=cachedCandidateSimplices[th].begin();it!=it_end;++it)
 		checkRefine_checkConflicts(*it,cancelledThread[th],toRefineThread[th]);
@@ -2593,7 +2644,7 @@ public:
       // Now we want to import all the candidate segments that belong to ghosts simplices
       // Note that we already computed those whose vertices are shared vertices, but not
       // the ones with at least one ghost vertex !
-      if (LocalMesh::getNGhostSimplices()>0) 
+      if ((LocalMesh::getNGhostSimplices()>0)||(ghostExchange.useNeighborCollectives())) 
 	{	  
 	  glb::console->printFlush<LOG_PEDANTIC>("(ghosts) ");	 
 	  
@@ -2656,104 +2707,26 @@ public:
 	   
       //LocalMesh::resetSimplicesCache(nThreads);  
       LocalMesh::resetGhostSimplicesCache(nThreads);     
-      std::vector<Simplex*> conflictSimplices;
       
       // Now we can check for second order conflicts (i.e a simplex that is
       // refined by at least two other simplices)
       // => for any given simplex, only one edge may be refined at a time
-      // After this loop, any cancelled candidate score will be negated
-      // FIXME: any safe way to use openMP here ?
-      for (candidate_iterator it=toRefine.begin();it!=toRefine.end();++it)
-	{
-	  // Those ones where cancelled by direct neighbors 
-	  // We are being conservative here : those with negative score, that were already 
-	  // cancelled by remote conflicts, can still cancel other refinements so that the 
-	  // result is deterministic !
-	  if (it->first==0) continue;
-	  	  
-	  segment_circulator ci_end=it->second->getCirculator();
-	  segment_circulator ci=ci_end;	  
-	  
-	  // for each candidate, tag any simplex its refinement will affect
-	  // with a pointer to it (in ci->cache.ptr)
-	  do
-	    {
-	      if (ci->cache.ptr==NULL)
-		{
-		  // this simplex is not yet affected by anything
-		  ci->cache.ptr = static_cast<void*>(&(*it));
-		}
-	      else
-		{
-		  // this simplex is already affected by a refinement !
-		  CandidateSegment *other = static_cast<CandidateSegment*>(ci->cache.ptr);
-		  Simplex *otherS=other->second->getSimplex();
-		  Simplex *curS=it->second->getSimplex();
-		  float diff = fabs(other->first) - fabs(it->first);
-		  if (diff>0)
-		    {
-		      // cancel current candidate
-		      curS->cache.ptr = static_cast<void*>(&(*other));
-		      it->first = -fabs(it->first);
-		    }
-		  else if (diff<0)
-		    {
-		      // cancel the other simplex's candidate
-		      ci->cache.ptr=static_cast<void*>(&(*it));	
-		      other->first = -fabs(other->first);
-		      //otherS->cache.ptr=static_cast<void*>(&(*it));
-		    }
-		  else
-		    {		     
-		      // Two candidates with the exact same score are in conflict,
-		      GlobalIdentity otherGid = otherS->getGlobalIdentity(myRank);
-		      GlobalIdentity curGid = curS->getGlobalIdentity(myRank);
-		      if (curGid != otherGid)
-			{
-			  bool cmp = LocalMesh::compareSegmentHandlesLess
-			    (it->second,other->second,true);
-			  /*
-			  // importance is decided by comparing the simplices global ID
-			  // This works but does not give nice results !
-			  bool cmp = (otherGid>curGid);
-			  */
-			  if (cmp)
-			    {
-			      // cancel current candidate
-			      curS->cache.ptr = static_cast<void*>(&(*other));
-			      it->first = -fabs(it->first);
-			    }
-			  else 
-			    {
-			      // cancel the other simplex's candidate
-			      ci->cache.ptr=static_cast<void*>(&(*it));
-			      other->first = -fabs(other->first);
-			      //otherS->cache.ptr=static_cast<void*>(&(*it));
-			    }						  
-			}
+      // After this, any cancelled candidate score will be negated
+      refine_selectNonConflicting(toRefine,nThreads,params.refineSelectionRounds);
 
-		      
-		      // NB : we don't do anything when the two candidates are the same !
-		      // This WILL happen, as we also test previously cancelled candidates
-		      // for possible conflicts !
-		    }		 
-		}
-	    } while ((++ci)!=ci_end);
-	}
+      // Set the cache of every simplex candidate to a pointer to its segment and
+      // score. Note that we DO include the cancelled ones (negative score)
+      // but not the initially cancelled ones (score == 0)
+      for (candidate_iterator it=toRefine.begin();it!=toRefine.end();++it)
+	if (it->first != 0) 
+	  it->second->getSimplex()->cache.ptr=&(*it);
 
       // Now it is still possible that a ghost simplex was cancelled remotely but
       // not locally. 
       long nRemoteConflicts=0;        
       // Check possible leftover conflicts with remote processes
-      if (LocalMesh::getNGhostSimplices()>0) 
+      if ((LocalMesh::getNGhostSimplices()>0)||(ghostExchange.useNeighborCollectives())) 
 	{
-	  // Set the cache of every simplex candidate to a pointer to its segment and
-	  // score. Note that we DO include the previously cancelled ones (negative score)
-	  // but not the initially cancelled ones (score == 0)
-	  for (candidate_iterator it=toRefine.begin();it!=toRefine.end();++it)
-	    if (it->first != 0) 
-	      it->second->getSimplex()->cache.ptr=&(*it);
-	  
 	  glb::console->printFlush<LOG_PEDANTIC>("(ghosts) ");	 
 	  
 	  std::vector< std::vector< MpiExchg_RefineQueryResult > > 
@@ -2861,6 +2834,25 @@ public:
       // Enable cached candidates for next pass
       useCachedCandidates=true;
 
+      // Any simplex incident to a candidate segment may have its cache modified,
+      // remember them so that we do not need to reset the whole mesh cache for the
+      // next pass.
+#pragma omp parallel for num_threads(nThreads)
+      for (long th=0;th<nThreads;th++)
+	{
+	  touchedThread[th].clear();
+	  for (unsigned long i=th;i<toRefine.size();i+=nThreads)
+	    {
+	      if (toRefine[i].first==0) continue;
+	      segment_circulator ci_end=toRefine[i].second->getCirculator();
+	      segment_circulator ci=ci_end;
+	      do
+		{
+		  touchedThread[th].push_back(*ci);
+		} while ((++ci)!=ci_end);
+	    }
+	}
+
       long nGhostRefined=0;
       unsigned long toRefineCount=0;
       // We can now build a final list of segments to refine ...
@@ -2968,18 +2960,29 @@ public:
 			       nNewSimplicesCum,
 			       solver,nThreads);
       
-      // Add split simplices to  cachedCandidateSimplices for next pass
+      // Add split simplices to  cachedCandidateSimplices for next pass. The score of a 
+      // simplex only changes when it is split, so we only need to keep the candidates 
+      // that were not split (split simplices are tagged, see above) and both halves of
+      // the split ones.
 #pragma omp parallel for num_threads(nThreads)
       for (int th=0; th<nThreads; th++)
 	{
+	  std::vector<Simplex *> &cached = cachedCandidateSimplices[th];
+	  cached.erase(std::remove_if(cached.begin(),cached.end(),
+				      isTaggedSimplex<Simplex>),
+		       cached.end());
+
 	  long delta=newSimplices.size()/nThreads;
 	  long start = th*delta;
 	  long stop = (th+1)*delta;
 	  if (th==nThreads-1) stop=newSimplices.size();
 	  for (long j=start;j<stop;++j)
 	    {
+	      // the partner of new simplex B is A, its neighbor at index cache.c[0]
+	      // (we do not rely on the tree, as there is none in tree free mode)
 	      cachedCandidateSimplices[th].push_back(newSimplices[j]);
-	      cachedCandidateSimplices[th].push_back(newSimplices[j]->getPartner());
+	      cachedCandidateSimplices[th].push_back
+		(newSimplices[j]->getNeighbor(newSimplices[j]->cache.c[0]));
 	    }
 	}      
       
@@ -2991,7 +2994,7 @@ public:
       std::vector<Simplex*> newSimplicesG;
       std::vector<unsigned long> nNewSimplicesCumG;
 
-      if (LocalMesh::getNGhostSimplices()>0)
+      if ((LocalMesh::getNGhostSimplices()>0)||(ghostExchange.useNeighborCollectives()))
 	{
 	  synchronizeAfterSplitting(newSharedVerticesMap,
 				    LocalMesh::ghostVertexPool, 
@@ -3003,6 +3006,11 @@ public:
 #pragma omp parallel for num_threads(nThreads)
 	  for (int th=0; th<nThreads; th++)
 	    {
+	      std::vector<GhostSimplex *> &cached = cachedCandidateGSimplices[th];
+	      cached.erase(std::remove_if(cached.begin(),cached.end(),
+					  isTaggedSimplex<GhostSimplex>),
+			   cached.end());
+
 	      long delta=newSimplicesG.size()/nThreads;
 	      long start = th*delta;
 	      long stop = (th+1)*delta;
@@ -3027,7 +3035,7 @@ public:
       std::vector<Simplex*> newSimplicesS;
       std::vector<unsigned long> nNewSimplicesCumS;
       
-      if (LocalMesh::getNShadowSimplices()>0)
+      if ((LocalMesh::getNShadowSimplices()>0)||(shadowExchange.useNeighborCollectives()))
 	synchronizeAfterSplitting(newSharedVerticesMap,
 				  LocalMesh::shadowVertexPool, 
 				  LocalMesh::shadowSimplexPool,
@@ -3044,6 +3052,15 @@ public:
       if (LocalMesh::getNShadowSimplices()>0)
 	LocalMesh::fixSimplicesNeighborsAfterSplitting(newVerticesS,newSimplicesS,
 						       nNewSimplicesCumS,false);  
+
+      // Clean up the cache before next pass. Split simplices are reset too, but they
+      // will be evaluated again anyway.
+#pragma omp parallel for num_threads(nThreads)
+      for (long th=0;th<nThreads;th++)
+	{
+	  for (unsigned long j=0;j<touchedThread[th].size();++j)
+	    touchedThread[th][j]->cache.ptr=NULL;
+	}
       /*
       // Need to clean the cache if we are going to use cached candidates
       if (useCachedCandidates)
@@ -3565,10 +3582,28 @@ public:
    * previous split.
    * \param solver a pointer to an object implementing a function 
    * checkCoarsen. See description hereabove for more information.
+   * \param trimOnly if true, no simplex is merged and only the ghost/shadow layer 
+   * is reduced to its minimum (see trimGhostLayer()).
+   * \note Nothing can be coarsened in tree free mode (see MeshParamsT::treeFree), as
+   * the partners of split simplices are not tracked. The ghost/shadow layer is still 
+   * trimmed in that case.
    */
   template <class C>
-  long coarsen(C *solver)
+  long coarsen(C *solver, bool trimOnly=false)
   {      
+    if ((!trimOnly)&&(Tree::isTreeFree()))
+      {
+	static bool warned=false;
+	if (!warned)
+	  {
+	    PRINT_SRC_INFO(LOG_WARNING);
+	    glb::console->print<LOG_WARNING>("Mesh coarsening is impossible in tree free mode (see 'mesh.treeFree'), only trimming the ghost layer.\n");
+	    warned=true;
+	  }
+	trimOnly=true;
+      }
+    if (trimOnly&&(mpiCom->size()<2)) return 0;
+
     if (glb::debug>1)
       dumpToNDnetwork("before_coarsening",
 		      IO::NDNET_WithShadows|
@@ -3584,11 +3619,12 @@ public:
     const int myRank=mpiCom->rank();
     const int nParts = mpiCom->size();
 
+    const char *what = (trimOnly)?"Trimming ghost layer ... ":"Coarsening ... ";
     if ((!glb::console->willPrint<LOG_INFO>())&&(glb::console->willPrint<LOG_STD>())) 
-      glb::console->printFlush<LOG_STD>("Coarsening ... "); 
+      glb::console->printFlush<LOG_STD>(what); 
 
     //glb::console->printFlush<LOG_INFO>("Coarsening the mesh (P%d) ... ",pass++);
-    glb::console->printFlush<LOG_INFO>("Coarsening ... ");
+    glb::console->printFlush<LOG_INFO>(what);
 
     glb::console->printFlush<LOG_PEDANTIC>("(candidates) ");
 
@@ -3610,14 +3646,19 @@ public:
     // deleted without being in conflict with the fact that S can only be merged with 
     // its partner by removing a given vertex.
     // FIXME invert the tagging to lower the computational time ?
-    // FIXME writing the tags does not make openMP happy ;)
-    //FIXME #pragma omp parallel for
-    //for (long th=0;th<glb::num_omp_threads;++th)
+    // NB: tags are only ever set here, so we just need the flag updates to be atomic
+    // as several threads may tag the same vertex. Only the thread processing 'cur'
+    // writes to cur->cache and partner->cache as we only consider partner>cur
+    // When only trimming, nothing is tagged and no candidate is selected below.
+    const int nThreads=glb::num_omp_threads;
+    LocalMesh::prepareSimplexThreadIteration(nThreads);
+    if (!trimOnly)
+#pragma omp parallel for num_threads(nThreads)
+    for (long th=0;th<nThreads;++th)
       {	
 	const simplexPtr_iterator it_end=LocalMesh::simplexEnd();
-	for (simplexPtr_iterator it=LocalMesh::simplexBegin();it!=it_end;++it)
-     // for (simplexPtr_iterator it=LocalMesh::simplexBegin(th,glb::num_omp_threads);
-     //      it!=it_end;++it)
+	for (simplexPtr_iterator it=LocalMesh::simplexBegin(th,nThreads);
+	     it!=it_end;++it)
 	  {
 	    Simplex *cur=*it;
 	    Simplex *partner=cur->getPartnerNotShared();
@@ -3627,7 +3668,7 @@ public:
 		// This simplex is unrefined or its partner has been further refined, 
 		// so we cannot delete ANY of its vertices
 		for (int i=0;i<Simplex::NVERT;++i) 
-		  cur->getVertex(i)->setTaggedF();
+		  cur->getVertex(i)->setTaggedF_atomic();
 		// cur->cache.ptr = NULL;
 	      }
 	    else if (partner>cur) // so that we don't inspect the simplices twice
@@ -3641,7 +3682,7 @@ public:
 		    Vertex *v=cur->getVertex(i);
 		    if (v!=vRef) 
 		      {
-			v->setTaggedF();
+			v->setTaggedF_atomic();
 			if (cur->getNeighbor(i)==partner) 
 			  cur->cache.ptr = v;
 		      }
@@ -3651,7 +3692,7 @@ public:
 		    Vertex *v=partner->getVertex(i);
 		    if (v!=vRef) 
 		      {
-			v->setTaggedF();
+			v->setTaggedF_atomic();
 			if (partner->getNeighbor(i)==cur) 
 			  partner->cache.ptr = v;
 		      }
@@ -3743,11 +3784,13 @@ public:
     // Now we want to create a list of simplices for each vertex that can be coarsened
     // without conflict. 
     // N.B.: For each vertex, we only want ONE simplex.
-#pragma omp parallel for
-    for (long th=0;th<glb::num_omp_threads;++th)
+    std::vector< std::vector<Simplex*> > candidatesThread(nThreads);
+    if (!trimOnly)
+#pragma omp parallel for num_threads(nThreads)
+    for (long th=0;th<nThreads;++th)
       {	
 	const simplexPtr_iterator it_end=LocalMesh::simplexEnd();
-	for (simplexPtr_iterator it=LocalMesh::simplexBegin(th,glb::num_omp_threads);
+	for (simplexPtr_iterator it=LocalMesh::simplexBegin(th,nThreads);
 	     it!=it_end;++it)
 	  {
 	    Simplex *cur=*it;
@@ -3756,18 +3799,17 @@ public:
 	    if ((partner!=NULL)&&(partner>cur))
 	      {	
 		// check if the vertex it would refine is available
+		// if it is not tagged, we have a candidate for coarsening, and tagging
+		// vRef ensures that we have only one simplex associated to it
 		Vertex *vRef=cur->getVertex(cur->getSplitIndex());
-#pragma omp critical
-		if (!vRef->isTagged()) 
-		  {
-		    // not tagged => we have a candidate for coarsening
-		    candidates.push_back(cur);
-		    // tag vRef so that we have only one simplex associated to it
-		    vRef->setTaggedF();
-		  }	
+		if (vRef->testAndSetTaggedF()) 
+		  candidatesThread[th].push_back(cur);
 	      }
 	  }
       }
+    for (long th=0;th<nThreads;++th)
+      candidates.insert(candidates.end(),
+			candidatesThread[th].begin(),candidatesThread[th].end());
 
   
     // These will store the local ids of the deleted vertices and simplices
@@ -3820,15 +3862,17 @@ public:
 	glb::console->printFlush<LOG_PEDANTIC>("(removing) ");		
 
 	// Now that we have the list of all the vertices that could be deleted, check
-	// whether we should remove them.
-	// FIXME: use openMP here ?
-#pragma omp parallel for
-	for (long th=0;th<glb::num_omp_threads;++th)
+	// whether we should remove them. For each accepted candidate, we store the
+	// pairs of simplices {s1[n],s2[n]} that will be merged when removing its vertex.
+	std::vector< std::vector<SimplexPair> > pairsThread(nThreads);
+	std::vector< std::vector<CoarsenCandidate> > acceptedThread(nThreads);
+#pragma omp parallel for num_threads(nThreads)
+	for (long th=0;th<nThreads;++th)
 	  {
-	    const unsigned long delta=candidates.size()/glb::num_omp_threads;
+	    const unsigned long delta=candidates.size()/nThreads;
 	    const unsigned long i0=th*delta;
 	    const unsigned long imax=
-	      (th==(glb::num_omp_threads-1))?candidates.size():i0+delta;
+	      (th==(nThreads-1))?candidates.size():i0+delta;
 	   
 	    // This will be used to store all the simplices that will be merged when 
 	    // removing a vertex. We declare them here to avoid reallocations.
@@ -3878,87 +3922,120 @@ public:
 		if (solver->checkCoarsen(s1,s2,curV,partnerV,v))
 		  {
 		    // YES -> remove this vertex by merging s1[n] with s2[n]
-#pragma omp critical
-		    {		    		    		   		    
-		      for (unsigned long n=0;n<s2.size();++n)
-			{		
-			  Simplex *rm=s2[n];
-			  Simplex *keep=s1[n];	
-
-			  if (s2[n]->isShadowOrGhost())
-			    continue;		   			  
-
-			  // Select which one is deleted, which one is expanded.
-			  // We let Simplex::merge decide so that it is done consistently
-			  rm = s2[n]->merge(Tree::nodePool);
-			  keep = (s1[n]==rm)?s2[n]:s1[n];
-			  int keepIndex=-1;
-			  // update the neighbors' neighbors
-			  for (int j=0;j<Simplex::NNEI;++j)
-			    {
-			      Simplex *nei=rm->getNeighbor(j);
-			      if (nei!=NULL)
-				{
-				  if (nei!=keep)
-				    {
-				      int k=nei->getNeighborIndex(rm);
-				      // neighbors's neighbors may already have been 
-				      // updated so we have to check that 'rm' is still 
-				      // considered a neighbor by its neighbor ...
-				      if (k>=0) nei->setNeighbor(k,keep);
-				    }
-				  else keepIndex = j;
-				}
-			    }
+		    CoarsenCandidate c;
+		    c.v=v;
+		    c.pairsIndex=pairsThread[th].size();
+		    c.nPairs=s1.size();
+		    for (unsigned long n=0;n<s1.size();++n)
+		      pairsThread[th].push_back(SimplexPair(s1[n],s2[n]));
+		    acceptedThread[th].push_back(c);
+		  }
+	      } // end check candidates	    
+	  } // end openMP loop
 
-			  // update 'keep' neighbors
-			  int rmIndex=keep->getNeighborIndex(rm);
-			  int rmVId = rm->getVertexIndex(v);
-			  Simplex* newNei=rm->getNeighbor(rmVId);
-			  keep->setNeighbor(rmIndex,newNei);
-		  
-			  // Update keep's simplices data
-			  int keepVId = keep->getVertexIndex(v);
-			  
-			  Simplex::Data::template onCoarsenSimplex<MyType,Simplex,Vertex>
-			    (this,keep,keepVId,rmIndex,rm,rmVId,keepIndex,
-			     static_cast<Vertex*>(rm->cache.ptr));
+	// Gather accepted candidates, pairsThread will not be modified anymore
+	std::vector<CoarsenCandidate> accepted;
+	for (long th=0;th<nThreads;++th)
+	  {
+	    for (unsigned long i=0;i<acceptedThread[th].size();++i)
+	      {
+		CoarsenCandidate &c=acceptedThread[th][i];
+		c.pairs = (c.nPairs>0)?(&pairsThread[th][c.pairsIndex]):NULL;
+		accepted.push_back(c);
+	      }
+	  }
 
-			  // solver->onCoarsen(keep,keepVId,rmIndex,
-			  // 		    rm,rmVId,keepIndex,
-			  // 		    static_cast<Vertex*>(rm->cache.ptr));
+	// Update the tree, which is not thread safe. This does not depend on the
+	// neighborhood relations so it can be done beforehand. After that, each pair 
+	// stores {keep,rm} (or rm=NULL if the pair is not to be merged).
+	// We let Simplex::merge decide which simplex is deleted, which one is expanded
+	// so that it is done consistently
+	for (unsigned long a=0;a<accepted.size();++a)
+	  {
+	    SimplexPair *pairs=accepted[a].pairs;
+	    for (int n=0;n<accepted[a].nPairs;++n)
+	      {
+		if (pairs[n].second->isShadowOrGhost())
+		  {
+		    pairs[n].second=NULL;
+		    continue;
+		  }
+		Simplex *rm = pairs[n].second->merge(Tree::nodePool);
+		Simplex *keep = (pairs[n].first==rm)?pairs[n].second:pairs[n].first;
+		pairs[n]=SimplexPair(keep,rm);
+	      }
+	  }
 
-			  // and replace the deleted vertex in 'keep'
-			  keep->setVertex(keepVId,static_cast<Vertex*>(rm->cache.ptr));
-			  keep->setGeneration(keep->getGeneration().rank()-1,
-					      keep->getGeneration().id());
+	// Merging simplices around a vertex modifies their neighbor across the facet
+	// opposite to the vertex, so two candidates are in conflict when such a 
+	// neighbor belongs to the other candidate's star. Non-conflicting candidates
+	// can be processed in parallel, and we select them in successive independent
+	// sets (Jones-Plassmann).
+	std::vector<long> conflictIndex;
+	std::vector<long> conflict;
+	coarsen_buildConflicts(accepted,conflictIndex,conflict,nThreads);
+	
+	std::vector<long> remaining(accepted.size());
+	std::vector<char> selected(accepted.size(),0);
+	std::vector<char> done(accepted.size(),0);
+	for (unsigned long a=0;a<accepted.size();++a) remaining[a]=a;
 
-			  if (nParts>1)
-			    {
-			      // we'll need that info to communicate with other processes
-			      keep->cache.c[0]=keepVId; // removed vertex
-			      keep->cache.c[1]=rmIndex; // partner
-			      keep->cache.c[2]=rmVId; // removed vertex in rm
-			      keep->cache.c[3]=keepIndex; //partner in rm 
-			      modifiedSimplicesHash.insert(std::make_pair(keep,keep));
-			      modifiedSimplicesHash.insert(std::make_pair(rm,keep));
-			    }
-			  
-			  removedSimplicesLID.push_back(rm->getLocalIndex());
-			  LocalMesh::simplexPool.recycle(rm);
-			  
-			}
-		      // all simplices are now merged, we can delete the vertex.
-		      removedVerticesLID.push_back(v->getLocalIndex());	
-		      // if (glb::debug)
-		      // 	v->template print<LOG_STD_ALL>();
-		      if (v->isShared()) rmSharedVerticesSet.insert(v);
-		      LocalMesh::vertexPool.recycle(v);			      
-		    } // end critical		   
-		  } // end coarsening
-	      } // end check candidates	    
-	  } // end openMP loop
+	while (remaining.size()>0)
+	  {
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic,64)
+	    for (unsigned long i=0;i<remaining.size();++i)
+	      {
+		const long a=remaining[i];
+		const unsigned long pa=coarsen_priority(a);
+		bool sel=true;
+		for (long j=conflictIndex[a];j<conflictIndex[a+1];++j)
+		  {
+		    const long b=conflict[j];
+		    if (done[b]) continue;
+		    const unsigned long pb=coarsen_priority(b);
+		    if ((pb>pa)||((pb==pa)&&(b>a))) {sel=false;break;}
+		  }
+		selected[a]=sel;
+		if (sel) coarsen_mergeStar(accepted[a],nParts);
+	      }
+	    
+	    // remove processed candidates
+	    unsigned long nLeft=0;
+	    for (unsigned long i=0;i<remaining.size();++i)
+	      {
+		const long a=remaining[i];
+		if (selected[a]) done[a]=1;
+		else remaining[nLeft++]=a;
+	      }
+	    remaining.resize(nLeft);
+	  }
 
+	// Finally free the simplices and vertices, and keep track of what we changed
+	for (unsigned long a=0;a<accepted.size();++a)
+	  {
+	    SimplexPair *pairs=accepted[a].pairs;
+	    Vertex *v=accepted[a].v;
+	    for (int n=0;n<accepted[a].nPairs;++n)
+	      {
+		Simplex *keep=pairs[n].first;
+		Simplex *rm=pairs[n].second;
+		if (rm==NULL) continue;
+		
+		if (nParts>1)
+		  {
+		    modifiedSimplicesHash.insert(std::make_pair(keep,keep));
+		    modifiedSimplicesHash.insert(std::make_pair(rm,keep));
+		  }
+		removedSimplicesLID.push_back(rm->getLocalIndex());
+		LocalMesh::simplexPool.recycle(rm);
+	      }
+	    // all simplices are now merged, we can delete the vertex.
+	    removedVerticesLID.push_back(v->getLocalIndex());	
+	    // if (glb::debug)
+	    // 	v->template print<LOG_STD_ALL>();
+	    if (v->isShared()) rmSharedVerticesSet.insert(v);
+	    LocalMesh::vertexPool.recycle(v);
+	  }
       } // candidates.size() > 0
      
     // Declare the structures used to ISend : because we are transfering in the 
@@ -5477,6 +5554,9 @@ public:
     for (int i=0;i<nRequestsTotal;++i)
       mpiCom->Waitall(allRequests[i]);
 
+    // neighbor processes may have changed
+    updateExchangeNeighborhoods();
+
     if (glb::debug) checkConsistencyAndReport<LOG_ERROR>("coarsen");
     
     /*
@@ -5507,6 +5587,22 @@ public:
     return nCoarsened;
   }
 
+  /** \brief Reduces the ghost/shadow layer to its minimum without coarsening the mesh.
+   *
+   * As new ghosts are added but never removed during refinement, the ghost layer keeps
+   * growing if no coarsening or repartitioning occurs. This trims it back to the 
+   * simplices that have at least one local vertex and rebuilds the shadow layer 
+   * accordingly, exactly as coarsen() would do when no simplex can be merged.
+   * \return true if the layer was trimmed (i.e. there is more than one process)
+   */
+  bool trimGhostLayer()
+  {
+    if (mpiCom->size()<2) return false;
+    TrimOnlyCoarsenSolver dummy;
+    coarsen(&dummy,true);
+    return true;
+  }
+
   /** \brief Checks the general consistency of the mesh. This is used for debugging purpose.
    */
   template <class LOG>
@@ -5928,6 +6024,129 @@ protected:
   typedef typename UMapULL::iterator UMapULL_iterator;
   typedef typename UMapUL::iterator UMapUL_iterator; 
 
+  // used by trimGhostLayer() to call coarsen() without merging anything
+  struct TrimOnlyCoarsenSolver
+  {
+    bool checkCoarsen(std::vector<Simplex *> &s1, std::vector<Simplex *> &s2,
+		      Vertex *v1, Vertex *v2, Vertex *vSplit)
+    {
+      return false;
+    }
+  };
+
+  // used by repart() to pack the vertices and new ghost simplices sent to 
+  // another process chunk by chunk (see MpiChunkedExchangeT::send)
+  template <class IT, class OUT>
+  struct RepartChunkPacker
+  {
+    RepartChunkPacker(IT begin, int rank):it(begin),myRank(rank) {}
+
+    void operator()(OUT *out, long n)
+    {
+      for (long i=0;i<n;++i,++it) pack(out[i],*it);
+    }
+
+  private:
+    IT it;
+    int myRank;
+
+    void pack(MpiExchg_RepartVertices &out, Vertex *v) {out.set(v);}
+    void pack(MpiExchg_RepartSimplicesWithCache &out, Simplex *s) {out.set(s,myRank);}
+  };
+
+  // used by repart() to store the received ghost simplices and allocate those 
+  // that are not in the hash table yet (see MpiChunkedExchangeT::receive)
+  template <class H, class P>
+  struct RepartGhostUnpacker
+  {
+    RepartGhostUnpacker(std::vector< std::vector<MpiExchg_RepartSimplicesWithCache> > &r,
+			const std::vector<int> &rIndex, H &hash, P &pool):
+      received(r),receiveRankIndex(rIndex),simplicesHash(hash),ghostPool(pool)
+    {}
+
+    MpiExchg_RepartSimplicesWithCache *getBuffer(int source, long n)
+    {
+      std::vector<MpiExchg_RepartSimplicesWithCache> &r=
+	received[receiveRankIndex[source]];
+      long oldSize=r.size();
+      r.resize(oldSize+n);
+      return (n>0)?&r[oldSize]:NULL;
+    }
+
+    void operator()(int source, MpiExchg_RepartSimplicesWithCache *data, long n)
+    {
+      for (long j=0;j<n;++j)
+	{	    
+	  GlobalIdentityValue gid=data[j].gid;
+	  if (simplicesHash.find(gid)==simplicesHash.end())
+	    {
+	      GhostSimplex *gSimplex;
+	      ghostPool.pop(&gSimplex);
+	      gSimplex->setData(data[j].sData);
+	      gSimplex->setGeneration(data[j].generation);
+	      simplicesHash.insert(std::make_pair(gid,gSimplex));
+	    }
+	}
+    }
+
+  private:
+    std::vector< std::vector<MpiExchg_RepartSimplicesWithCache> > &received;
+    const std::vector<int> &receiveRankIndex;
+    H &simplicesHash;
+    P &ghostPool;
+  };
+
+  // used by repart() to allocate the received vertices that are not in the 
+  // hash table yet. Chunks are received in a single buffer that is reused
+  template <class H, class P>
+  struct RepartVertexUnpacker
+  {
+    RepartVertexUnpacker(H &hash, P &pool):
+      verticesHash(hash),vertexPool(pool)
+    {}
+
+    MpiExchg_RepartVertices *getBuffer(int source, long n)
+    {
+      if (n>(long)buffer.size()) buffer.resize(n);
+      return (n>0)?&buffer[0]:NULL;
+    }
+
+    void operator()(int source, MpiExchg_RepartVertices *data, long n)
+    {
+      for (long j=0;j<n;++j)
+	{   
+	  MpiExchg_RepartVertices &mpiVertex=data[j];
+	  if (verticesHash.find(mpiVertex.gid)==verticesHash.end())
+	    {
+	      Vertex *vertex;
+	      vertexPool.pop(&vertex);
+	      verticesHash.insert(std::make_pair(mpiVertex.gid,vertex));
+	      vertex->setCoords(mpiVertex.coords);	
+	      vertex->setData(mpiVertex.vData);	
+	      vertex->setGlobalIdentity(mpiVertex.gid);
+	      vertex->setGeneration(mpiVertex.generation);
+	      vertex->setSetF();	
+	    }
+	}
+    }
+
+  private:
+    H &verticesHash;
+    P &vertexPool;
+    std::vector<MpiExchg_RepartVertices> buffer;
+  };
+
+  // Enable neighborhood collectives for ghost/shadow exchanges if required (see
+  // MeshParamsT::neighborCollectives) and rebuild the graph of neighbor processes
+  // if it changed. This is a collective call.
+  void updateExchangeNeighborhoods()
+  {
+    ghostExchange.setNeighborCollectives(params.neighborCollectives);
+    shadowExchange.setNeighborCollectives(params.neighborCollectives);
+    ghostExchange.updateNeighborhood();
+    shadowExchange.updateNeighborhood();
+  }
+
   Params params; // mesh parameters
 
   MpiCommunication *mpiCom;
@@ -5987,11 +6206,13 @@ protected:
     std::vector<LocalIndex> index;   
   } incidentSimplices;
 
+  // Maximum number of simplices passed at once to solver->checkRefine_getValues
+  static const long CHECK_REFINE_BATCH_SIZE = 256;
+
   template <class Solver, class S>
-  void checkRefine_singleSimplex(Solver *solver, S *simplex, std::vector<S *> &cSimplices)
-  {
-    double result = solver->checkRefine_getValue(simplex);
-	      
+  void checkRefine_singleSimplex(Solver *solver, S *simplex, double result,
+				 std::vector<S *> &cSimplices)
+  {	      
     if (result<=0) simplex->cache.ptr=NULL; // clean up	      
     else 
       {
@@ -6008,6 +6229,27 @@ protected:
     simplex->setTaggedF(false);	
   }
 
+  // Evaluates the refinement criterion for simplices in [begin,end) by batches
+  template <class Solver, class S, class IT>
+  void checkRefine_batch(Solver *solver, IT begin, const IT &end, 
+			 std::vector<S *> &cSimplices)
+  {
+    S *batch[CHECK_REFINE_BATCH_SIZE];
+    double value[CHECK_REFINE_BATCH_SIZE];
+    
+    while (begin!=end)
+      {
+	long n=0;
+	for (;(begin!=end)&&(n<CHECK_REFINE_BATCH_SIZE);++begin) 
+	  batch[n++]=*begin;
+	
+	solver->checkRefine_getValues(batch,n,value);
+
+	for (long i=0;i<n;++i)
+	  checkRefine_singleSimplex(solver,batch[i],value[i],cSimplices);
+      }
+  }
+
   template <class S>
   void checkRefine_setSimplicesCache_fromCachedSimplices
   (S *solver, std::vector<char> &check, int nThreads,
@@ -6017,18 +6259,19 @@ protected:
     std::vector<std::vector<Simplex *> > newCSimplices(nThreads);
     std::vector<std::vector<GhostSimplex *> > newCGSimplices(nThreads);
 
+    // Local simplices caches are reset by refine() at the end of each pass, but 
+    // ghosts may also have been modified by remote processes.
     LocalMesh::resetGhostSimplicesCache(nThreads);
-    LocalMesh::resetSimplicesCache(nThreads);
     
 #pragma omp parallel num_threads(nThreads)
     {
 #pragma omp for nowait
       for (long i=0;i<nThreads;i++)
 	{
-	  for (auto it=cSimplices[i].begin(); it!=cSimplices[i].end(); ++it)
-	    checkRefine_singleSimplex(solver,*it,newCSimplices[i]);
-	  for (auto it=cGSimplices[i].begin(); it!=cGSimplices[i].end(); ++it)
-	    checkRefine_singleSimplex(solver,*it,newCGSimplices[i]);
+	  checkRefine_batch(solver,cSimplices[i].begin(),cSimplices[i].end(),
+			    newCSimplices[i]);
+	  checkRefine_batch(solver,cGSimplices[i].begin(),cGSimplices[i].end(),
+			    newCGSimplices[i]);
 	}
     }
 
@@ -6055,27 +6298,280 @@ protected:
 	  cSimplices[i].clear();
 	  cGSimplices[i].clear();
 
-	  const simplexPtr_iterator it_end=LocalMesh::simplexEnd();
-	  for (simplexPtr_iterator it=LocalMesh::simplexBegin(i,nThreads);
-	       it!=it_end;++it)
-	    checkRefine_singleSimplex(solver,*it,cSimplices[i]);	    
+	  checkRefine_batch(solver,LocalMesh::simplexBegin(i,nThreads),
+			    LocalMesh::simplexEnd(),cSimplices[i]);
 	  
 	  if (LocalMesh::getNGhostSimplices()>0)
 	    {
-	      const ghostSimplexPtr_iterator it_end=LocalMesh::ghostSimplexEnd();
-	      for (ghostSimplexPtr_iterator it=LocalMesh::ghostSimplexBegin(i,nThreads);
-		   it!=it_end;++it)
-		checkRefine_singleSimplex(solver,*it,cGSimplices[i]);
+	      checkRefine_batch(solver,LocalMesh::ghostSimplexBegin(i,nThreads),
+				LocalMesh::ghostSimplexEnd(),cGSimplices[i]);
 	    } // if ghostsSimplices
 
 	} //for loop
     } // omp parallel    
   }
 
-  // Eliminates first order conflicts during refinement
+  // Returns true if refining candidate segment b has priority over refining a. The
+  // order is arbitrary but deterministic and consistent over different processes.
+  template <class CS>
+  bool refine_hasPriority(const CS &b, const CS &a, int myRank) const
+  {
+    float diff = fabs(b.first) - fabs(a.first);
+    if (diff>0) return true;
+    if (diff<0) return false;
+
+    // Two candidates with the exact same score are in conflict,
+    Simplex *sa=a.second->getSimplex();
+    Simplex *sb=b.second->getSimplex();
+    // NB : nothing to decide when the two candidates are the same !
+    if (sa->getGlobalIdentity(myRank) == sb->getGlobalIdentity(myRank)) return false;
+    return LocalMesh::compareSegmentHandlesLess(a.second,b.second,true);
+  }
+
+  // Cancels candidate segments so that no simplex is refined by two different 
+  // segments. Candidates are in conflict when their segments share a simplex, and a 
+  // candidate is selected when it has priority over every undecided candidate it is in
+  // conflict with, while those are cancelled. This is repeated (Jones-Plassmann) until
+  // every candidate is decided or nRounds rounds were done, leftovers being cancelled.
+  // With nRounds=1, a candidate is refined only if it has priority over all its 
+  // conflicting candidates, even cancelled ones. More rounds refine a larger 
+  // (eventually maximal) set of segments during each pass, so that less passes and 
+  // synchronizations are needed. Decisions taken for candidates on ghost simplices may
+  // then differ between processes, but the caller cancels any segment that was
+  // cancelled on one of them, which can only remove segments from an independent set.
+  // Cancelled candidates get a negative score (initially null scores are ignored).
   template <class CV>
+  void refine_selectNonConflicting(CV &toRefine, int nThreads, int nRounds)
+  {
+    enum {UNDECIDED=0, SELECTED=1, CANCELLED=2};
+    const int myRank=mpiCom->rank();
+    const long N=toRefine.size();
+    
+    std::vector< std::vector< std::pair<Simplex*,long> > > touchedThread(nThreads);
+#pragma omp parallel for num_threads(nThreads)
+    for (long th=0;th<nThreads;th++)
+      {
+	for (long i=th;i<N;i+=nThreads)
+	  {
+	    if (toRefine[i].first==0) continue;
+	    segment_circulator ci_end=toRefine[i].second->getCirculator();
+	    segment_circulator ci=ci_end;
+	    do
+	      {
+		touchedThread[th].push_back(std::make_pair(*ci,i));
+	      } while ((++ci)!=ci_end);
+	  }
+      }
+    
+    std::vector<long> conflictIndex;
+    std::vector<long> conflict;
+    buildConflictGraph(touchedThread,N,conflictIndex,conflict);
+    
+    std::vector<char> state(N,UNDECIDED);
+    std::vector<long> undecided;
+    undecided.reserve(N);
+    for (long i=0;i<N;++i)
+      {
+	if (toRefine[i].first==0) state[i]=CANCELLED;
+	else undecided.push_back(i);
+      }
+
+    for (int round=0;(undecided.size()>0)&&((nRounds<=0)||(round<nRounds));++round)
+      {
+	std::vector<char> select(undecided.size(),1);
+#pragma omp parallel for num_threads(nThreads)
+	for (unsigned long i=0;i<undecided.size();++i)
+	  {
+	    const long a=undecided[i];
+	    for (long j=conflictIndex[a];j<conflictIndex[a+1];++j)
+	      {
+		const long b=conflict[j];
+		if (state[b]==CANCELLED) continue;
+		if (refine_hasPriority(toRefine[b],toRefine[a],myRank))
+		  {
+		    select[i]=0;
+		    break;
+		  }
+	      }
+	  }
+	for (unsigned long i=0;i<undecided.size();++i)
+	  if (select[i]) state[undecided[i]]=SELECTED;
+	
+	// candidates in conflict with a selected one are cancelled
+	std::vector<char> cancel(undecided.size(),0);
+#pragma omp parallel for num_threads(nThreads)
+	for (unsigned long i=0;i<undecided.size();++i)
+	  {
+	    const long a=undecided[i];
+	    if (state[a]!=UNDECIDED) continue;
+	    for (long j=conflictIndex[a];j<conflictIndex[a+1];++j)
+	      if (state[conflict[j]]==SELECTED)
+		{
+		  cancel[i]=1;
+		  break;
+		}
+	  }
+
+	unsigned long nLeft=0;
+	for (unsigned long i=0;i<undecided.size();++i)
+	  {
+	    const long a=undecided[i];
+	    if (cancel[i]) state[a]=CANCELLED;
+	    else if (state[a]==UNDECIDED) undecided[nLeft++]=a;
+	  }
+	undecided.resize(nLeft);
+      }
+
+    for (long i=0;i<N;++i)
+      if (state[i]!=SELECTED) 
+	toRefine[i].first = -fabs(toRefine[i].first);
+  }
+
+  // Enforces a predefined refinement order (see refine()). A candidate is deferred if
+  // the segment it wants to split is not the one that an incident local simplex would 
+  // split, and such simplices become candidates themselves with the same score. This 
+  // is repeated for the new candidates until every candidate is compatible with its
+  // incident simplices, which terminates when the order is the longest edge one (we
+  // then follow the longest edge propagation path of each candidate). Non local 
+  // simplices cannot be made candidates locally, so they never defer a candidate.
+  // Deferred candidates are evaluated again during the next pass.
+  // cSimplices is updated with the new candidates.
+  template <class S>
+  long checkRefine_predefinedOrderClosure(S *solver, int nThreads,
+					  std::vector<std::vector<Simplex *> > &cSimplices)
+  {
+    struct Request
+    {
+      Request(Simplex *s, float f, int i):simplex(s),score(f),index(i) {}
+      bool operator<(const Request &other) const 
+      {
+	if (simplex!=other.simplex) return simplex<other.simplex;
+	return score>other.score;
+      }
+      Simplex *simplex;
+      float score;
+      int index;
+    };
+    // That's way more than enough with the longest edge order
+    static const int maxIterations = 64;
+
+    std::vector<Simplex*> sources;
+    for (unsigned long th=0;th<cSimplices.size();++th)
+      for (unsigned long i=0;i<cSimplices[th].size();++i)
+	if (cSimplices[th][i]->cache.pfi.f>0)
+	  sources.push_back(cSimplices[th][i]);
+
+    std::vector<Simplex*> deferred;
+    std::vector<Simplex*> raised;
+    std::vector< std::vector<Simplex*> > deferThread(nThreads);
+    std::vector< std::vector<Request> > raiseThread(nThreads);
+    for (int iter=0;(iter<maxIterations)&&(sources.size()>0);++iter)
+      {
+#pragma omp parallel for num_threads(nThreads)
+	for (long th=0;th<nThreads;++th)
+	  {
+	    deferThread[th].clear();
+	    raiseThread[th].clear();
+	    for (unsigned long i=th;i<sources.size();i+=nThreads)
+	      {
+		Simplex *s=sources[i];
+		const float score=s->cache.pfi.f;
+		const SegmentHandle h=s->getSegmentHandle(s->cache.pfi.i);
+		const Vertex *v0=h->getVertex(0);
+		const Vertex *v1=h->getVertex(1);
+		bool defer=false;
+
+		segment_circulator ci_end=h->getCirculator();
+		segment_circulator ci=ci_end;
+		do
+		  {
+		    Simplex *other=*ci;
+		    if ((other==s)||(!other->isLocal())) continue;
+
+		    int index;
+		    if (other->cache.pfi.f>0) 
+		      index=other->cache.pfi.i;
+		    else
+		      {
+			double tmp=score;
+			index=solver->checkRefine_getSplitSegmentIndex(other,tmp);
+		      }
+		    SegmentHandle oh=other->getSegmentHandle(index);
+		    const Vertex *ov0=oh->getVertex(0);
+		    const Vertex *ov1=oh->getVertex(1);
+		    if (((ov0==v0)&&(ov1==v1))||((ov0==v1)&&(ov1==v0)))
+		      continue;
+
+		    defer=true;
+		    if ((!other->isTagged())&&(other->cache.pfi.f<score))
+		      raiseThread[th].push_back(Request(other,score,index));
+		  } while ((++ci)!=ci_end);
+
+		if (defer) deferThread[th].push_back(s);
+	      }
+	  }
+	
+	// Deferred candidates are tagged so that they are not raised again
+	for (long th=0;th<nThreads;++th)
+	  for (unsigned long i=0;i<deferThread[th].size();++i)
+	    {
+	      Simplex *s=deferThread[th][i];
+	      s->cache.ptr=NULL;
+	      s->setTaggedF();
+	      deferred.push_back(s);
+	    }
+
+	std::vector<Request> requests;
+	for (long th=0;th<nThreads;++th)
+	  requests.insert(requests.end(),raiseThread[th].begin(),raiseThread[th].end());
+	// the highest score comes first for each simplex
+	std::sort(requests.begin(),requests.end());
+
+	sources.clear();
+	for (unsigned long i=0;i<requests.size();++i)
+	  {
+	    Simplex *s=requests[i].simplex;
+	    if ((i>0)&&(requests[i-1].simplex==s)) continue;
+	    if ((s->isTagged())||(s->cache.pfi.f>=requests[i].score)) continue;
+	    if (s->cache.pfi.f<=0) raised.push_back(s);
+	    s->cache.pfi.f=requests[i].score;
+	    s->cache.pfi.i=requests[i].index;
+	    sources.push_back(s);
+	  }
+      }
+
+    for (unsigned long i=0;i<deferred.size();++i)
+      deferred[i]->setTaggedF(false);
+    
+    // Add the new candidates to the list, avoiding duplicates as some of them may 
+    // have been evaluated with a null score already.
+    if (raised.size()>0)
+      {
+	std::vector<Simplex*> all(raised);
+	for (unsigned long th=0;th<cSimplices.size();++th)
+	  {
+	    all.insert(all.end(),cSimplices[th].begin(),cSimplices[th].end());
+	    cSimplices[th].clear();
+	  }
+	std::sort(all.begin(),all.end());
+	all.erase(std::unique(all.begin(),all.end()),all.end());
+	for (unsigned long i=0;i<all.size();++i)
+	  cSimplices[i%cSimplices.size()].push_back(all[i]);
+      }
+
+    return deferred.size();
+  }
+
+  template <class S>
+  static bool isTaggedSimplex(const S *simplex)
+  {
+    return simplex->isTagged();
+  }
+
+  // Eliminates first order conflicts during refinement
+  template <class SV, class CV>
   void checkRefine_checkConflicts(Simplex *simplex, 
-				  std::vector<Simplex*> &cancelled,
+				  SV &cancelled,
 				  CV &toRefine)
   {    
     float score = simplex->cache.pfi.f;
@@ -6139,6 +6635,169 @@ protected:
       cancelled.push_back(simplex);   
   }
 
+  // Helpers for coarsen().
+  // A vertex accepted for removal, and the pairs of simplices {s1[n],s2[n]} that merge
+  // when it is removed (which become {keep,rm} once the tree is updated)
+  typedef std::pair<Simplex*,Simplex*> SimplexPair;
+  struct CoarsenCandidate
+  {
+    Vertex *v;
+    SimplexPair *pairs;
+    unsigned long pairsIndex;
+    int nPairs;
+  };
+
+  // Two candidates conflict when one of them modifies a simplex that the other one
+  // reads or modifies, i.e. when a simplex is touched (rm or one of its neighbors) by 
+  // both. conflict[conflictIndex[a]] to conflict[conflictIndex[a+1]-1] are the
+  // candidates in conflict with accepted[a].
+  void coarsen_buildConflicts(const std::vector<CoarsenCandidate> &accepted,
+			      std::vector<long> &conflictIndex,
+			      std::vector<long> &conflict,
+			      int nThreads)
+  {
+    typedef std::pair<Simplex*,long> Touched;
+    std::vector< std::vector<Touched> > touchedThread(nThreads);
+#pragma omp parallel for num_threads(nThreads)
+    for (long th=0;th<nThreads;++th)
+      {
+	for (unsigned long a=th;a<accepted.size();a+=nThreads)
+	  {
+	    const SimplexPair *pairs=accepted[a].pairs;
+	    for (int n=0;n<accepted[a].nPairs;++n)
+	      {
+		Simplex *rm=pairs[n].second;
+		if (rm==NULL) continue;
+		touchedThread[th].push_back(Touched(rm,a));
+		for (int j=0;j<Simplex::NNEI;++j)
+		  {
+		    Simplex *nei=rm->getNeighbor(j);
+		    if (nei!=NULL) touchedThread[th].push_back(Touched(nei,a));
+		  }
+	      }
+	  }
+      }
+    
+    buildConflictGraph(touchedThread,accepted.size(),conflictIndex,conflict);
+  }
+
+  // Builds a conflict graph between nItems items, where two items are in conflict when
+  // they touch a common object. touchedThread[th] holds {object,item} pairs (one list
+  // per thread) and is consumed. conflict[conflictIndex[a]] to 
+  // conflict[conflictIndex[a+1]-1] are the items in conflict with item a.
+  template <class O>
+  static void buildConflictGraph(std::vector< std::vector< std::pair<O,long> > > 
+				 &touchedThread,
+				 long nItems,
+				 std::vector<long> &conflictIndex,
+				 std::vector<long> &conflict)
+  {
+    typedef std::pair<O,long> Touched;
+    std::vector<Touched> touched;
+    for (unsigned long th=0;th<touchedThread.size();++th)
+      {
+	touched.insert(touched.end(),touchedThread[th].begin(),touchedThread[th].end());
+	std::vector<Touched>().swap(touchedThread[th]);
+      }
+    std::sort(touched.begin(),touched.end());
+    touched.erase(std::unique(touched.begin(),touched.end()),touched.end());
+
+    std::vector< std::pair<long,long> > edges;
+    for (unsigned long i=0;i<touched.size();)
+      {
+	unsigned long j=i+1;
+	while ((j<touched.size())&&(touched[j].first==touched[i].first)) ++j;
+	for (unsigned long k=i;k<j;++k)
+	  for (unsigned long l=k+1;l<j;++l)
+	    {
+	      edges.push_back(std::make_pair(touched[k].second,touched[l].second));
+	      edges.push_back(std::make_pair(touched[l].second,touched[k].second));
+	    }
+	i=j;
+      }
+    std::sort(edges.begin(),edges.end());
+    edges.erase(std::unique(edges.begin(),edges.end()),edges.end());
+
+    conflictIndex.assign(nItems+1,0);
+    conflict.resize(edges.size());
+    for (unsigned long i=0;i<edges.size();++i)
+      {
+	conflictIndex[edges[i].first+1]++;
+	conflict[i]=edges[i].second;
+      }
+    for (long a=0;a<nItems;++a)
+      conflictIndex[a+1]+=conflictIndex[a];
+  }
+
+  // An arbitrary but deterministic priority used to select independent sets of 
+  // candidates. Hashing avoids long chains of conflicting candidates with increasing 
+  // indices, that would need as many rounds.
+  static unsigned long coarsen_priority(unsigned long a)
+  {
+    a = (a ^ (a >> 30)) * 0xbf58476d1ce4e5b9UL;
+    a = (a ^ (a >> 27)) * 0x94d049bb133111ebUL;
+    return a ^ (a >> 31);
+  }
+
+  // Merges the simplices around a removed vertex (the tree must have been updated 
+  // already). Simplices are not recycled here.
+  void coarsen_mergeStar(const CoarsenCandidate &c, int nParts)
+  {
+    Vertex *v=c.v;
+    for (int n=0;n<c.nPairs;++n)
+      {
+	Simplex *keep=c.pairs[n].first;
+	Simplex *rm=c.pairs[n].second;
+	if (rm==NULL) continue;
+
+	int keepIndex=-1;
+	// update the neighbors' neighbors
+	for (int j=0;j<Simplex::NNEI;++j)
+	  {
+	    Simplex *nei=rm->getNeighbor(j);
+	    if (nei!=NULL)
+	      {
+		if (nei!=keep)
+		  {
+		    int k=nei->getNeighborIndex(rm);
+		    // neighbors's neighbors may already have been 
+		    // updated so we have to check that 'rm' is still 
+		    // considered a neighbor by its neighbor ...
+		    if (k>=0) nei->setNeighbor(k,keep);
+		  }
+		else keepIndex = j;
+	      }
+	  }
+
+	// update 'keep' neighbors
+	int rmIndex=keep->getNeighborIndex(rm);
+	int rmVId = rm->getVertexIndex(v);
+	Simplex* newNei=rm->getNeighbor(rmVId);
+	keep->setNeighbor(rmIndex,newNei);
+		  
+	// Update keep's simplices data
+	int keepVId = keep->getVertexIndex(v);
+			  
+	Simplex::Data::template onCoarsenSimplex<MyType,Simplex,Vertex>
+	  (this,keep,keepVId,rmIndex,rm,rmVId,keepIndex,
+	   static_cast<Vertex*>(rm->cache.ptr));
+
+	// and replace the deleted vertex in 'keep'
+	keep->setVertex(keepVId,static_cast<Vertex*>(rm->cache.ptr));
+	keep->setGeneration(keep->getGeneration().rank()-1,
+			    keep->getGeneration().id());
+
+	if (nParts>1)
+	  {
+	    // we'll need that info to communicate with other processes
+	    keep->cache.c[0]=keepVId; // removed vertex
+	    keep->cache.c[1]=rmIndex; // partner
+	    keep->cache.c[2]=rmVId; // removed vertex in rm
+	    keep->cache.c[3]=keepIndex; //partner in rm 
+	  }
+      }
+  }
+
   // Synchronize boundaries after refining.
   // Used as helper function for refine().
   // sharedVerticesMap maps the globalIdentity of a simplex (before splitting) with the 
@@ -6893,6 +7552,7 @@ protected:
 	glb::console->printFlush<LOG_PEDANTIC>("(com) ");
 	initExchangeCells(ghostArr,simplexTable,vertexTable,ghostExchange);	
 	initExchangeCells(shadowArr,simplexTable,vertexTable,shadowExchange);
+	updateExchangeNeighborhoods();
 	//shadowSimplicesSend = shadowExchange.send;
 	//shadowSimplicesReceive = shadowExchange.receive;
 	//sendNeighborNodesRank = shadowExchange.sendRank;
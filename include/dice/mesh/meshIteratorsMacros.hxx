@@ -13,6 +13,7 @@
 // Batch macros
 #define FOREACH_BATCH_SIMPLEX(mesh,nThreads,nBatches,iVar,itVar)\
   {const int foreach_loop_count = (nThreads==1)?1:(nThreads*nBatches);	\
+  mesh->prepareSimplexThreadIteration(foreach_loop_count);\
   FOREACH_BATCH_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     simplexPtr_iterator itVar=mesh->simplexBegin(iVar,foreach_loop_count);\
@@ -20,6 +21,7 @@
 
 #define FOREACH_BATCH_SIMPLEX_LG(mesh,nThreads,nBatches,iVar,itVar)\
   {const int foreach_loop_count = (nThreads==1)?1:(nThreads*nBatches);\
+  mesh->prepareSimplexThreadIteration(foreach_loop_count,true,true);\
   FOREACH_BATCH_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     simplexPtr_LG_iterator itVar=mesh->simplexLGBegin(iVar,foreach_loop_count);\
@@ -27,6 +29,7 @@
 
 #define FOREACH_BATCH_SIMPLEX_LGS(mesh,nThreads,nBatches,iVar,itVar)\
   {const int foreach_loop_count = (nThreads==1)?1:(nThreads*nBatches);\
+  mesh->prepareSimplexThreadIteration(foreach_loop_count,true,true,true);\
   FOREACH_BATCH_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     simplexPtr_LGS_iterator itVar=mesh->simplexLGSBegin(iVar,foreach_loop_count);\
@@ -34,6 +37,7 @@
 
 #define FOREACH_BATCH_VERTEX(mesh,nThreads,nBatches,iVar,itVar)\
   {const int foreach_loop_count = (nThreads==1)?1:(nThreads*nBatches);\
+  mesh->prepareVertexThreadIteration(foreach_loop_count);\
   FOREACH_BATCH_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     vertexPtr_iterator itVar=mesh->vertexBegin(iVar,foreach_loop_count);\
@@ -41,6 +45,7 @@
 
 #define FOREACH_BATCH_VERTEX_LG(mesh,nThreads,nBatches,iVar,itVar)\
   {const int foreach_loop_count = (nThreads==1)?1:(nThreads*nBatches);\
+  mesh->prepareVertexThreadIteration(foreach_loop_count,true,true);\
   FOREACH_BATCH_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     vertexPtr_LG_iterator itVar=mesh->vertexLGBegin(iVar,foreach_loop_count);\
@@ -48,6 +53,7 @@
 
 #define FOREACH_BATCH_VERTEX_LGS(mesh,nThreads,nBatches,iVar,itVar)\
   {const int foreach_loop_count = (nThreads==1)?1:(nThreads*nBatches);\
+  mesh->prepareVertexThreadIteration(foreach_loop_count,true,true,true);\
   FOREACH_BATCH_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     vertexPtr_LGS_iterator itVar=mesh->vertexLGSBegin(iVar,foreach_loop_count);\
@@ -58,6 +64,7 @@
 // thread macros (i.e. =1 batch)
 #define FOREACH_THREAD_SIMPLEX(mesh,nThreads,iVar,itVar)\
   {const int foreach_loop_count = nThreads;\
+  mesh->prepareSimplexThreadIteration(foreach_loop_count);\
   FOREACH_THREAD_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     simplexPtr_iterator itVar=mesh->simplexBegin(iVar,nThreads);\
@@ -65,6 +72,7 @@
 
 #define FOREACH_THREAD_SIMPLEX_LG(mesh,nThreads,iVar,itVar)\
   {const int foreach_loop_count = nThreads;\
+  mesh->prepareSimplexThreadIteration(foreach_loop_count,true,true);\
   FOREACH_THREAD_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     simplexPtr_LG_iterator itVar=mesh->simplexLGBegin(iVar,nThreads);\
@@ -72,6 +80,7 @@
 
 #define FOREACH_THREAD_SIMPLEX_LGS(mesh,nThreads,iVar,itVar)\
   {const int foreach_loop_count = nThreads;\
+  mesh->prepareSimplexThreadIteration(foreach_loop_count,true,true,true);\
   FOREACH_THREAD_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     simplexPtr_LGS_iterator itVar=mesh->simplexLGSBegin(iVar,nThreads);\
@@ -79,6 +88,7 @@
 
 #define FOREACH_THREAD_VERTEX(mesh,nThreads,iVar,itVar)\
   {const int foreach_loop_count = nThreads;\
+  mesh->prepareVertexThreadIteration(foreach_loop_count);\
   FOREACH_THREAD_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     vertexPtr_iterator itVar=mesh->vertexBegin(iVar,nThreads);\
@@ -86,6 +96,7 @@
 
 #define FOREACH_THREAD_VERTEX_LG(mesh,nThreads,iVar,itVar)\
   {const int foreach_loop_count = nThreads;\
+  mesh->prepareVertexThreadIteration(foreach_loop_count,true,true);\
   FOREACH_THREAD_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     vertexPtr_LG_iterator itVar=mesh->vertexLGBegin(iVar,nThreads);\
@@ -93,6 +104,7 @@
 
 #define FOREACH_THREAD_VERTEX_LGS(mesh,nThreads,iVar,itVar)\
   {const int foreach_loop_count = nThreads;\
+  mesh->prepareVertexThreadIteration(foreach_loop_count,true,true,true);\
   FOREACH_THREAD_MESH_CELL_OPENMP_ARG(nThreads)\
   for (int iVar=0;iVar<foreach_loop_count;++iVar){\
     vertexPtr_LGS_iterator itVar=mesh->vertexLGSBegin(iVar,nThreads);\
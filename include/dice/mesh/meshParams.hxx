@@ -37,7 +37,7 @@ struct MeshParamsT
 
   static std::string parserCategory() {return "mesh";}
   static std::string classHeader() {return "mesh_params";}
-  static float classVersion() {return 0.10;}
+  static float classVersion() {return 0.11;}
   static float compatibleSinceClassVersion() {return 0.10;}
 
   typedef C Coord;
@@ -53,6 +53,10 @@ struct MeshParamsT
   double initPartitionTolerance; //!< tolerance on work load for initial partition
   double repartTolerance; //!< tolerance on work load for partitions (after repartitionning)
   double repartThreshold; //!< Repartition is triggered when max(nSimplex)/min(nSimplex) > repartThreshold
+  int refineSelectionRounds; //!< max rounds selecting non conflicting segments per refinement pass
+  int treeFree; //!< do not keep the tree of split simplices (the mesh cannot be coarsened)
+  int neighborCollectives; //!< exchange ghost/shadow data with MPI-3 neighborhood collectives
+  long repartChunkSize; //!< max number of vertices / ghost simplices per message when repartitionning (<=0 for unlimited)
   
   MeshParamsT()
   {
@@ -135,6 +139,10 @@ struct MeshParamsT
     repartTolerance=initPartitionTolerance;
     repartThreshold=1.15; // Allow 15% imbalance max
     allocFactor=1.0; // Alloc 100% new objects when a container is full (->double the size)
+    refineSelectionRounds=16; // 1 means only locally dominant candidates are refined
+    treeFree=0;
+    neighborCollectives=0;
+    repartChunkSize=1<<16;
 
     //initTesselationType = TesselationType::ANY;
     initPartitionType = PartitionType::KWAY;
@@ -175,6 +183,7 @@ struct MeshParamsT
     writer->write(&initPartitionTolerance);
     //writer->write(&repartTolerance);
     //writer->write(&repartThreshold);
+    writer->write(&treeFree);
   }
 
   template <class BR>
@@ -197,6 +206,8 @@ struct MeshParamsT
     reader->read(&initPartitionTolerance);
     //reader->read(&repartTolerance);
     //reader->read(&repartThreshold);
+    if (version>0.105) reader->read(&treeFree);
+    else treeFree=0;
   }
 
   template <class BR, class PM>
@@ -245,6 +256,27 @@ struct MeshParamsT
       get("repartThreshold",parserCategory(),repartThreshold,
 	  reader,PM::PARSER_FIRST,
 	  "Inbalance factor that triggers repartitionning");
+
+    refineSelectionRounds=manager.
+      get("refineSelectionRounds",parserCategory(),refineSelectionRounds,
+	  reader,PM::PARSER_FIRST,
+	  "Maximum number of rounds selecting non conflicting segments during each refinement pass (<=0 for unlimited)");
+
+    treeFree=manager.
+      get("treeFree",parserCategory(),treeFree,
+	  reader,PM::FILE_FIRST,
+	  "Set to drop the tree of split simplices, saving memory and time when refining. The mesh cannot be coarsened in that case.",
+	  serializedVersion>0.105);
+
+    neighborCollectives=manager.
+      get("neighborCollectives",parserCategory(),neighborCollectives,
+	  reader,PM::PARSER_FIRST,
+	  "Set to exchange ghost and shadow simplices data with neighborhood collectives over a graph of neighbor processes instead of point to point communications (requires MPI-3)");
+
+    repartChunkSize=manager.
+      get("repartChunkSize",parserCategory(),repartChunkSize,
+	  reader,PM::PARSER_FIRST,
+	  "Maximum number of vertices or ghost simplices sent in a single message when migrating the mesh during repartitionning (<=0 for unlimited)");
     /*	     
     std::string initTesselationTypeStr = manager.template 
       get<std::string>("initTesselationType",parserCategory(),
@@ -306,6 +338,22 @@ struct MeshParamsT
     repartThreshold=parser.
       get("repartThreshold",parserCategory(),repartThreshold,
 	  "Inbalance factor that triggers repartitionning");
+
+    refineSelectionRounds=parser.
+      get("refineSelectionRounds",parserCategory(),refineSelectionRounds,
+	  "Maximum number of rounds selecting non conflicting segments during each refinement pass (<=0 for unlimited)");
+
+    treeFree=parser.
+      get("treeFree",parserCategory(),treeFree,
+	  "Set to drop the tree of split simplices, saving memory and time when refining. The mesh cannot be coarsened in that case.");
+
+    neighborCollectives=parser.
+      get("neighborCollectives",parserCategory(),neighborCollectives,
+	  "Set to exchange ghost and shadow simplices data with neighborhood collectives over a graph of neighbor processes instead of point to point communications (requires MPI-3)");
+
+    repartChunkSize=parser.
+      get("repartChunkSize",parserCategory(),repartChunkSize,
+	  "Maximum number of vertices or ghost simplices sent in a single message when migrating the mesh during repartitionning (<=0 for unlimited)");
     /*		     
     std::string initTesselationTypeStr = parser.template 
       get<std::string>("initTesselationType",parserCategory(),
@@ -42,6 +42,15 @@
  * the exchange to finish with wait(...). 
  * The later version may be faster in some cases when one needs to cache
  * computations while the transfer occurs ...
+ * Cells cache values can also be synchronized with cacheExchange(), which reuses 
+ * persistent MPI requests as long as the exchange pattern does not change.
+ *
+ * When enabled with setNeighborCollectives(), the exchange functions rely on MPI-3 
+ * neighborhood collectives over a distributed graph communicator that connects
+ * each process to its actual neighbors only, and data is transfered in place 
+ * (i.e. without packing it in intermediate buffers). The graph must then be rebuilt 
+ * with updateNeighborhood() each time sendRank or receiveRank change, and all the 
+ * processes must take part in every exchange, even if they have no neighbors.
  * \tparam C  The type of local cell (e.g. Simplex or Vertex)
  * \tparam EC The type of the exchange cell (e.g. the image of a remote cell, such as a 
  *            GhostSimplex or ShadowSimplex)
@@ -81,11 +90,60 @@ struct MpiCellDataExchangeT {
     mpiCom(mpiCom_),
     defaultTag(mpiCom_->reserveTags(1)),
     send(mpiCom_->size()),
-    receive(mpiCom_->size())
+    receive(mpiCom_->size()),
+    neighborhoodEnabled(false),
+    neighborhoodBuilt(false)
   {    
     mpiCom->barrier();
   }
 
+  ~MpiCellDataExchangeT()
+  {
+    persistent.free(mpiCom);
+    freeNeighborhood();
+  }
+
+  /** \brief Use neighborhood collectives instead of point to point communications 
+   *  in the exchange functions (only if MPI-3 is available and there is more than
+   *  one process). This is a collective call, and updateNeighborhood() must be 
+   *  called after it for the setting to take effect.
+   */
+  void setNeighborCollectives(bool enable)
+  {
+    neighborhoodEnabled = 
+      enable && MpiCommunication::hasNeighborCollectives() && (mpiCom->size()>1);
+    if (!neighborhoodEnabled) freeNeighborhood();
+  }
+
+  //! true if exchange functions use neighborhood collectives
+  bool useNeighborCollectives() const
+  {
+    return neighborhoodBuilt;
+  }
+
+  /** \brief (Re)build the distributed graph communicator used by neighborhood 
+   *  collectives if sendRank or receiveRank changed on any process since it 
+   *  was last built. This is a collective call that does nothing if neighborhood 
+   *  collectives are not enabled (see setNeighborCollectives()).
+   */
+  void updateNeighborhood()
+  {
+    if (!neighborhoodEnabled) return;
+
+    int changed = ((!neighborhoodBuilt)||
+		   (neighborSendRank!=sendRank)||
+		   (neighborReceiveRank!=receiveRank));
+    if (!mpiCom->max(changed)) return;
+
+    freeNeighborhood();
+    // [0] is used for regular exchanges and [1] for reversed ones
+    mpiCom->Dist_graph_create_adjacent(receiveRank,sendRank,&neighborCom[0]);
+    mpiCom->Dist_graph_create_adjacent(sendRank,receiveRank,&neighborCom[1]);
+    neighborSendRank=sendRank;
+    neighborReceiveRank=receiveRank;
+    neighborhoodBuilt=true;
+  }
+
   template <class W>
   void serialize(W *writer)
   {   
@@ -563,6 +621,20 @@ struct MpiCellDataExchangeT {
 	for (long i=0;i<nReceive;i++)
 	  receiveData[i].resize(receive[receiveRank[i]].size()); 
       }
+
+    if (neighborhoodReady())
+      {
+	for (long i=0;i<nSend;i++)
+	  {
+#pragma omp parallel for
+	    for (unsigned long j=0;j<toSend[i].size();j++)
+	      sendData[i][j]=toSend[i][j].getMpiStruct();
+	  }
+	if ((DT::IS_INDEXED)||(!autoResize))
+	  neighborResize(sendData,receiveData,0);
+	neighborAlltoallw(sendData,receiveData,mpiStructType,0);
+	return;
+      }
    
     for (long i=0;i<nReceive;i++)
       {
@@ -617,6 +689,14 @@ struct MpiCellDataExchangeT {
 	for (long i=0;i<nReceive;i++)
 	  receiveData[i].resize(receive[receiveRank[i]].size()); 
       }
+
+    if (neighborhoodReady())
+      {
+	if ((DT::IS_INDEXED)||(!autoResize))
+	  neighborResize(toSend,receiveData,0);
+	neighborAlltoallw(toSend,receiveData,mpiStructType,0);
+	return;
+      }
    
     for (long i=0;i<nReceive;i++)
       {
@@ -674,6 +754,12 @@ struct MpiCellDataExchangeT {
 
     for (long i=0;i<nReceive;i++)
       receiveData[i].resize(receive[receiveRank[i]].size());      
+
+    if (neighborhoodReady())
+      {
+	neighborAlltoallw(toSend,receiveData,MPI_Type<DT>::get(),0);
+	return;
+      }
    
     for (long i=0;i<nReceive;i++)
       {
@@ -707,6 +793,12 @@ struct MpiCellDataExchangeT {
 
     for (long i=0;i<nReceive;i++)
       receiveData[i].resize(send[sendRank[i]].size()); 
+
+    if (neighborhoodReady())
+      {
+	neighborAlltoallw(toSend,receiveData,MPI_Type<DT>::get(),1);
+	return;
+      }
    
     for (long i=0;i<nReceive;i++)
       {
@@ -743,6 +835,14 @@ struct MpiCellDataExchangeT {
 	for (long i=0;i<nReceive;i++)
 	  receiveData[i].resize(send[sendRank[i]].size()); 
       }
+
+    if (neighborhoodReady())
+      {
+	if ((DT::IS_INDEXED)||(!autoResize))
+	  neighborResize(toSend,receiveData,1);
+	neighborAlltoallw(toSend,receiveData,mpiStructType,1);
+	return;
+      }
    
     for (long i=0;i<nReceive;i++)
       {
@@ -798,6 +898,20 @@ struct MpiCellDataExchangeT {
 	for (long i=0;i<nReceive;i++)
 	  receiveData[i].resize(send[sendRank[i]].size()); 
       }
+
+    if (neighborhoodReady())
+      {
+	for (long i=0;i<nSend;i++)
+	  {
+#pragma omp parallel for
+	    for (unsigned long j=0;j<toSend[i].size();j++)
+	      sendData[i][j]=toSend[i][j].getMpiStruct();
+	  }
+	if ((DT::IS_INDEXED)||(!autoResize))
+	  neighborResize(sendData,receiveData,1);
+	neighborAlltoallw(sendData,receiveData,mpiStructType,1);
+	return;
+      }
    
     for (long i=0;i<nReceive;i++)
       {
@@ -855,7 +969,215 @@ struct MpiCellDataExchangeT {
     reversedExchangeStruct(toSend,mpiReceive,mpiStructType,true,tag);
     reversedConvert(mpiReceive,receiveData);   
   }
-  
+
+  /** \brief Copy the first sizeof(CacheT) bytes of the cache of the local cells 
+   * in send to the cache of their images in receive on remote processes.
+   *
+   * The MPI requests are persistent: they are created on the first call and simply 
+   * restarted by the next ones, as long as the ranks and the number of cells exchanged
+   * with each of them do not change. Otherwise, they are freed and created again.
+   * Packing and unpacking the buffers are distributed over all openMP threads.
+   */
+  template <typename CacheT>
+  void cacheExchange()
+  {
+    const long nSend=sendRank.size();
+    const long nReceive=receiveRank.size();
+    const long sz=sizeof(CacheT);
+
+    if (nSend+nReceive==0) return;
+    if (!persistent.matches(this,sz))
+      persistent.create(this,sz);
+
+#pragma omp parallel
+    {
+      for (long i=0;i<nSend;i++)
+	{
+	  const std::vector<Cell*> &cur=send[sendRank[i]];
+	  char *buffer=&persistent.sendBuffer[persistent.sendOffset[i]*sz];
+#pragma omp for nowait
+	  for (long j=0;j<(long)cur.size();j++)
+	    memcpy(buffer+j*sz,&(cur[j]->cache.ui64),sz);
+	}
+    }
+
+    mpiCom->Startall(persistent.reqs);
+    mpiCom->Waitall(persistent.reqs);
+
+#pragma omp parallel
+    {
+      for (long i=0;i<nReceive;i++)
+	{
+	  const std::vector<ExchangeCell*> &cur=receive[receiveRank[i]];
+	  const char *buffer=&persistent.receiveBuffer[persistent.receiveOffset[i]*sz];
+#pragma omp for nowait
+	  for (long j=0;j<(long)cur.size();j++)
+	    memcpy(&(cur[j]->cache.ui64),buffer+j*sz,sz);
+	}
+    }
+  }
+
+private:
+
+  bool neighborhoodEnabled;
+  bool neighborhoodBuilt;
+  MPI_Comm neighborCom[2];
+  std::vector<int> neighborSendRank;
+  std::vector<int> neighborReceiveRank;
+
+  void freeNeighborhood()
+  {
+    if (!neighborhoodBuilt) return;
+    mpiCom->Comm_free(&neighborCom[0]);
+    mpiCom->Comm_free(&neighborCom[1]);
+    neighborhoodBuilt=false;
+  }
+
+  // true if the exchange should go through neighborhood collectives
+  bool neighborhoodReady() const
+  {
+    if (!neighborhoodBuilt) return false;
+    if ((neighborSendRank!=sendRank)||(neighborReceiveRank!=receiveRank))
+      {
+	PRINT_SRC_INFO(LOG_ERROR);
+	glb::console->print<LOG_ERROR>
+	  ("Exchange pattern changed but the neighborhood was not updated (call updateNeighborhood()).\n");
+	exit(-1);
+      }
+    return true;
+  }
+
+  // Resize receiveData to the number of elements sent by each source in 
+  // graph neighborCom[reversed]
+  template <class ST, class RT>
+  void neighborResize(std::vector< std::vector<ST> > &toSend,
+		      std::vector< std::vector<RT> > &receiveData,
+		      int reversed)
+  {
+    const long nSend=(reversed)?receiveRank.size():sendRank.size();
+    const long nReceive=(reversed)?sendRank.size():receiveRank.size();
+    // one more element so that the first address is always valid
+    std::vector<long> sendCount(nSend+1);
+    std::vector<long> receiveCount(nReceive+1);
+    for (long i=0;i<nSend;i++)
+      sendCount[i]=toSend[i].size();
+
+    mpiCom->Neighbor_alltoall(&sendCount[0],&receiveCount[0],neighborCom[reversed]);
+
+    for (long i=0;i<nReceive;i++)
+      receiveData[i].resize(receiveCount[i]);
+  }
+
+  // Send toSend[i] to the i-th destination and receive receiveData[i] from the
+  // i-th source of graph neighborCom[reversed]. receiveData must be allocated.
+  template <class ST, class RT>
+  void neighborAlltoallw(std::vector< std::vector<ST> > &toSend,
+			 std::vector< std::vector<RT> > &receiveData,
+			 MPI_Datatype type, int reversed)
+  {
+    const long nSend=(reversed)?receiveRank.size():sendRank.size();
+    const long nReceive=(reversed)?sendRank.size():receiveRank.size();
+    std::vector<int> sendCounts(nSend);
+    std::vector<int> receiveCounts(nReceive);
+    std::vector<MPI_Aint> sendAddresses(nSend,0);
+    std::vector<MPI_Aint> receiveAddresses(nReceive,0);
+    std::vector<MPI_Datatype> sendTypes(nSend,type);
+    std::vector<MPI_Datatype> receiveTypes(nReceive,type);
+
+    for (long i=0;i<nSend;i++)
+      {
+	sendCounts[i]=toSend[i].size();
+	if (sendCounts[i]) sendAddresses[i]=mpiCom->getAddress(&toSend[i][0]);
+      }
+    for (long i=0;i<nReceive;i++)
+      {
+	receiveCounts[i]=receiveData[i].size();
+	if (receiveCounts[i]) receiveAddresses[i]=mpiCom->getAddress(&receiveData[i][0]);
+      }
+
+    mpiCom->Neighbor_alltoallw(sendCounts,sendAddresses,sendTypes,
+			       receiveCounts,receiveAddresses,receiveTypes,
+			       neighborCom[reversed]);
+  }
+
+  // Persistent requests and buffers used by cacheExchange()
+  class PersistentRequests
+  {
+  public:
+    std::vector<int> sendRank;
+    std::vector<int> receiveRank;
+    std::vector<long> sendOffset;
+    std::vector<long> receiveOffset;
+    std::vector<char> sendBuffer;
+    std::vector<char> receiveBuffer;
+    std::vector<MPI_Request> reqs;
+    long elementSize;
+
+    PersistentRequests():elementSize(0)
+    {}
+
+    // Requests are bound to their buffers, so they are never copied
+    PersistentRequests(const PersistentRequests &other):elementSize(0)
+    {}
+
+    // true if the requests can be reused for the current exchange pattern of 'ex'
+    bool matches(const MyType *ex, long sz) const
+    {
+      if ((sz!=elementSize)||
+	  (sendRank!=ex->sendRank)||
+	  (receiveRank!=ex->receiveRank))
+	return false;
+
+      for (unsigned long i=0;i<sendRank.size();i++)
+	if (sendOffset[i+1]-sendOffset[i] != (long)ex->send[sendRank[i]].size())
+	  return false;
+      for (unsigned long i=0;i<receiveRank.size();i++)
+	if (receiveOffset[i+1]-receiveOffset[i] != 
+	    (long)ex->receive[receiveRank[i]].size())
+	  return false;
+
+      return true;
+    }
+
+    void create(const MyType *ex, long sz)
+    {
+      free(ex->mpiCom);
+      elementSize=sz;
+      sendRank=ex->sendRank;
+      receiveRank=ex->receiveRank;
+
+      sendOffset.assign(1,0);
+      for (unsigned long i=0;i<sendRank.size();i++) 
+	sendOffset.push_back(sendOffset.back()+ex->send[sendRank[i]].size());
+      receiveOffset.assign(1,0);
+      for (unsigned long i=0;i<receiveRank.size();i++) 
+	receiveOffset.push_back(receiveOffset.back()+ex->receive[receiveRank[i]].size());
+
+      // never empty so that the address of the first element is always valid
+      sendBuffer.resize(sendOffset.back()*sz+1);
+      receiveBuffer.resize(receiveOffset.back()*sz+1);
+      
+      reqs.resize(receiveRank.size()+sendRank.size());
+      for (unsigned long i=0;i<receiveRank.size();i++)
+	ex->mpiCom->Recv_init(&receiveBuffer[receiveOffset[i]*sz],
+			      (receiveOffset[i+1]-receiveOffset[i])*sz,
+			      receiveRank[i],&reqs[i],ex->defaultTag);
+      for (unsigned long i=0;i<sendRank.size();i++)
+	ex->mpiCom->Send_init(&sendBuffer[sendOffset[i]*sz],
+			      (sendOffset[i+1]-sendOffset[i])*sz,
+			      sendRank[i],&reqs[receiveRank.size()+i],ex->defaultTag);
+    }
+
+    void free(const MpiCommunication *com)
+    {
+      for (unsigned long i=0;i<reqs.size();i++)
+	com->Request_free(&reqs[i]);
+      reqs.clear();
+      elementSize=0;
+    }
+  };
+
+  PersistentRequests persistent;
 };
 
 /** \}*/
@@ -13,6 +13,7 @@
 #include "../tools/memory/memoryPool.hxx"
 #include "../tools/memory/iterableMemoryPool.hxx"
 #include "../tools/IO/paramsParser.hxx"
+#include "../tools/sort/peanoHilbert.hxx"
 
 #include "../partition/parmetisParams.hxx"
 #include "../partition/partitioner.hxx"
@@ -81,6 +82,7 @@ protected:
     shadowRootPool("ShadowRoot",allocFactor)
   {
     curMode=NETWORK;
+    treeFree=false;
     mpiType_sharedTreeRoot=MpiExchg_SharedTreeRoot::MpiStruct::createMpiStructType();
     #pragma omp critical
     { 
@@ -119,6 +121,20 @@ protected:
     shadowRootPool.setAllocFactor(factor);
   }
 
+  // In tree free mode, no node is ever allocated: every leaf directly points to the 
+  // root it descends from, which is enough to keep track of the roots weight and to 
+  // repartition, but partners cannot be retrieved so leaves can never be merged. 
+  // This must be set before the tree is built and cannot change afterward.
+  void setTreeFree(bool set=true)
+  {
+    treeFree=set;
+  }
+
+  bool isTreeFree() const
+  {
+    return treeFree;
+  }
+
   template <class W>
   void write(W *writer)
   {
@@ -134,8 +150,9 @@ protected:
     shadowRootPool.serialize(writer);
   }
 
-  template <class EPU>
-  void defrag(const EPU &epu)
+  // [leafBegin,leafEnd[ must span all the local leaves, see updateFlatLeaves()
+  template <class EPU, class LeafIterator>
+  void defrag(const EPU &epu, LeafIterator leafBegin, LeafIterator leafEnd)
   {
     typedef typename NodePool::UnserializedPointerUpdater NodePointerUpdater;
     typedef typename RootPool::UnserializedPointerUpdater RootPointerUpdater;
@@ -152,7 +169,7 @@ protected:
 	for (network_iterator it=networkBegin(i,glb::num_omp_threads);
 	     it!=it_end;++it)	
 	  {
-	    (*it)->updateAfterUnserialized(*rpu,*srpu,*npu,*epu,true,swap);
+	    (*it)->updateAfterUnserialized(*rpu,*srpu,*npu,*epu,!treeFree,swap);
 	  }
 	const network_iterator sit_end=shadowNetworkEnd();
 	for (network_iterator it=shadowNetworkBegin(i,glb::num_omp_threads);
@@ -161,10 +178,13 @@ protected:
 	    (*it)->updateAfterUnserialized(*rpu,*srpu,*npu,*epu,false,swap);	    
 	  }	
       }
+
+    if (treeFree) updateFlatLeaves(*rpu,leafBegin,leafEnd);
   }
 
-  template <class R, class EPU>
-  void build(R *reader, const EPU &epu)
+  // [leafBegin,leafEnd[ must span all the local leaves, see updateFlatLeaves()
+  template <class R, class EPU, class LeafIterator>
+  void build(R *reader, const EPU &epu, LeafIterator leafBegin, LeafIterator leafEnd)
   {
     if (reader == NULL) return ;
     
@@ -200,7 +220,7 @@ protected:
 	for (network_iterator it=networkBegin(i,glb::num_omp_threads);
 	     it!=it_end;++it)	
 	  {
-	    (*it)->updateAfterUnserialized(*rpu,*srpu,*npu,*epu,true,swap);	  
+	    (*it)->updateAfterUnserialized(*rpu,*srpu,*npu,*epu,!treeFree,swap);	  
 	  }
 	const network_iterator sit_end=shadowNetworkEnd();
 	for (network_iterator it=shadowNetworkBegin(i,glb::num_omp_threads);
@@ -209,8 +229,31 @@ protected:
 	    (*it)->updateAfterUnserialized(*rpu,*srpu,*npu,*epu,false,swap);	    
 	  }	
       }
+    
+    if (treeFree) updateFlatLeaves(*rpu,leafBegin,leafEnd);
     glb::console->printFlush<LOG_INFO>("done.\n");
   }
+
+  // In tree free mode, roots cannot reach their leaves, so the leaves have to update 
+  // their (root) parent pointer themselves after the roots were moved. Any leaf of a 
+  // root can be its child, so we just keep the last one.
+  template <class RPU, class LeafIterator>
+  void updateFlatLeaves(const RPU &rpu, LeafIterator leafBegin, LeafIterator leafEnd)
+  {
+    for (LeafIterator it=leafBegin;it!=leafEnd;++it)
+      {
+	Leaf *leaf=static_cast<Leaf*>(*it);
+	Root *root=rpu(static_cast<Root*>(leaf->parent));
+	if (root==NULL)
+	  {
+	    PRINT_SRC_INFO(LOG_ERROR);
+	    glb::console->print<LOG_ERROR>("when unserializing : could not update leaf's root pointer !\n");
+	    exit(-1);
+	  }
+	leaf->parent=root;
+	root->setChild(leaf);
+      }
+  }
   
   Mode getMode() {return curMode;}
 
@@ -258,6 +301,7 @@ protected:
   typedef typename DenseHashGidGid::iterator DenseHashGidGid_it;  
 
   Mode curMode;
+  bool treeFree;
   MpiCommunication *mpiCom;
   NodePool nodePool;
   RootPool rootPool;
@@ -455,10 +499,13 @@ protected:
     return result;
   }
  
+  // if rootWeights is not NULL, it contains the computational weight of each root
+  // (indexed by local index) and weightPerCell is ignored
   bool generateParmetisGraph(ParmetisParams &p, 
 			     RefinePartitionType type, 
 			     double tolerance=1.05,
-			     double weightPerCell=1.0)
+			     double weightPerCell=1.0,
+			     const std::vector<double> *rootWeights=NULL)
   {
     //typedef typename ParmetisParams::Index Index;
     typedef typename ParmetisParams::Float PPFloat;
@@ -466,13 +513,29 @@ protected:
     // Weigth are integers so we need to scale them by a large enough factor,
     // but not too large so that we do not overflow an int capacity ...
     // => factor 100 means we have 2 digits precision ...
-    auto minMaxSum=mpiCom->minMaxSum(weightPerCell);
     double pwFactor=1.0;
-    // if (min == max) then all the weights can remain =1.0
-    if (minMaxSum.first.first != minMaxSum.first.second)
-      {	
-	double avg=minMaxSum.second / mpiCom->size();
-	pwFactor =  std::max(1.0,100.0 * (weightPerCell / avg));	
+    if (rootWeights!=NULL)
+      {
+	// Same scaling, but relative to the global average weight per cell
+	double sum[2]={0,0};
+	if (curMode == NETWORK)
+	  for (network_iterator it=networkBegin();it!=networkEnd();++it)
+	    {
+	      sum[0]+=(*rootWeights)[it->getLocalIndex()];
+	      sum[1]+=it->weight;
+	    }
+	mpiCom->sum(sum,2);
+	if (sum[0]>0) pwFactor=100.0*sum[1]/sum[0];
+      }
+    else
+      {
+	auto minMaxSum=mpiCom->minMaxSum(weightPerCell);
+	// if (min == max) then all the weights can remain =1.0
+	if (minMaxSum.first.first != minMaxSum.first.second)
+	  {	
+	    double avg=minMaxSum.second / mpiCom->size();
+	    pwFactor =  std::max(1.0,100.0 * (weightPerCell / avg));	
+	  }
       }
     
     if (curMode != NETWORK) return false;
@@ -546,7 +609,10 @@ protected:
 	    // Redistribution cost (memory size)
 	    p.vsize[id-1]= it->weight; 
 	    // Computational cost
-	    p.vwgt[id-1] = it->weight * pwFactor;
+	    if (rootWeights!=NULL)
+	      p.vwgt[id-1] = std::max(1.0,(*rootWeights)[id-1] * pwFactor + 0.5);
+	    else
+	      p.vwgt[id-1] = it->weight * pwFactor;
 	    checkSum+=p.vwgt[id-1];
 	  }
       }
@@ -580,27 +646,150 @@ protected:
     return true;
   }
   
+  // Compute the position of each local root node along a Peano-Hilbert curve spanning
+  // the global bounding box of the roots, as well as its computational weight.
+  // The key of a root is that of the first vertex of its first leaf, as for PH.
+  // keys are packed into an unsigned long (16 bits per dimension), returns the number
+  // of significant bits. If rootWeights is not NULL, it is used as the weight of each
+  // root instead of weightPerCell times its number of leaves.
+  int generateSFCKeys(std::vector<unsigned long> &keys,
+		      std::vector<double> &weights,
+		      double weightPerCell=1.0,
+		      const std::vector<double> *rootWeights=NULL)
+  {
+    typedef PeanoHilbertT<NDIM,16> PeanoHilbert;
+    typedef typename PeanoHilbert::HCode HCode;
+    static const int nBits = sizeof(typename PeanoHilbert::Index)*8;
+    typedef typename Element::Vertex Vertex;
+
+    updateRootNodesCount();
+    const unsigned long nRootNodes=getNRootNodes();
+    std::vector<double> coords(nRootNodes*NDIM);
+    keys.resize(nRootNodes);
+    weights.resize(nRootNodes);
+
+#pragma omp parallel for
+    for (long i=0;i<glb::num_omp_threads;i++)
+      {	
+	const network_iterator it_end=networkEnd();
+	for (network_iterator it=networkBegin(i,glb::num_omp_threads);it!=it_end;++it)
+	  {	 
+	    const unsigned long id = it->getLocalIndex();
+	    AnyNodeBase *any=it->getChild();
+
+	    while (!any->isLeaf()) any=static_cast<Node*>(any)->getChild(0);
+	    Vertex *v=static_cast<Element*>(static_cast<Leaf*>(any))->getVertex(0);
+	    for (int j=0;j<NDIM;++j) coords[id*NDIM+j]=v->getCoord(j);
+	    if (rootWeights!=NULL)
+	      weights[id]=(*rootWeights)[id];
+	    else
+	      weights[id]=it->weight * weightPerCell;
+	  }
+      }  
+
+    // global bounding box of the roots' coordinates
+    double x0[NDIM];
+    double x1[NDIM];
+    std::fill_n(x0,NDIM,std::numeric_limits<double>::max());
+    std::fill_n(x1,NDIM,-std::numeric_limits<double>::max());
+    for (unsigned long i=0;i<nRootNodes;++i)
+      for (int j=0;j<NDIM;++j)
+	{
+	  if (coords[i*NDIM+j]<x0[j]) x0[j]=coords[i*NDIM+j];
+	  if (coords[i*NDIM+j]>x1[j]) x1[j]=coords[i*NDIM+j];
+	}
+    mpiCom->min(x0,NDIM);
+    mpiCom->max(x1,NDIM);
+
+    double delta_inv[NDIM];
+    for (int j=0;j<NDIM;++j) 
+      delta_inv[j]=(x1[j]>x0[j])?1.0/(x1[j]-x0[j]):0;
+
+    // keys are computed by blocks with the batch version of coordsToLength
+    static const long blockSize=1024;
+    const long nBlocks=(nRootNodes+blockSize-1)/blockSize;
+#pragma omp parallel for
+    for (long b=0;b<nBlocks;++b)
+      {
+	HCode h[blockSize];
+	const long i0=b*blockSize;
+	const long n=std::min(blockSize,static_cast<long>(nRootNodes)-i0);
+	PeanoHilbert::coordsToLengths(&coords[i0*NDIM],n,h,x0,delta_inv);
+	for (long i=0;i<n;++i)
+	  {
+	    unsigned long key=0;
+	    for (int j=NDIM-1;j>=0;--j) 
+	      key = (key<<nBits) | static_cast<unsigned long>(h[i].hcode[j]);
+	    keys[i0+i]=key;
+	  }
+      }
+
+    return nBits*NDIM;
+  }
+
   // repartition the tree
+  // [leafBegin,leafEnd[ must span all the local leaves, it is only used in tree free mode
+  // to retrieve the leaves of each root.
+  // If rootWeights is not NULL, it contains the computational weight of each root 
+  // (indexed by local index) which is used instead of weightPerCell times the number of
+  // leaves of the root.
+  // If presetPartition is true, partition already contains the destination rank of 
+  // each root (indexed by local index) and the partitioner is not called.
   // FIXME : post an Irecv before Isend and use waitall ...
+  template <class LeafIterator>
   bool repart(std::vector<PartitionerIndex> &partition,       
 	      RefinePartitionType type,
 	      double tolerance,
 	      double weightPerCell,
 	      MpiCellDataExchangeT<Element,AnyNodeBase> &leavesExchange,
-	      int nThreads=glb::num_omp_threads)	
+	      LeafIterator leafBegin, LeafIterator leafEnd,
+	      int nThreads=glb::num_omp_threads,
+	      const std::vector<double> *rootWeights=NULL,
+	      bool presetPartition=false)	
   {
     const int myRank = mpiCom->rank();
     const int nParts = mpiCom->size();    
 
     ParmetisParams p(mpiCom);
     // drawGraph("GRAPH-PRE");
-    glb::console->printFlush<LOG_INFO>("Repartitioning root nodes (%s) ... ",RefinePartitionTypeSelect().getString(type).c_str());
+    if (presetPartition)
+      glb::console->printFlush<LOG_INFO>("Repartitioning root nodes (preset) ... ");
+    else
+      glb::console->printFlush<LOG_INFO>("Repartitioning root nodes (%s) ... ",RefinePartitionTypeSelect().getString(type).c_str());
 
-    glb::console->printFlush<LOG_PEDANTIC>("(graph) ");    
-    if (!generateParmetisGraph(p,type,tolerance,weightPerCell)) return false;
+    if (presetPartition)
+      {
+	if (curMode != NETWORK) return false;
+	updateRootNodesCount();
+	if (partition.size()!=getNRootNodes()) 
+	  {
+	    PRINT_SRC_INFO(LOG_ERROR);
+	    glb::console->print<LOG_ERROR>("Preset partition has %ld elements instead of %ld.\n",
+					   (long)partition.size(),(long)getNRootNodes());
+	    exit(-1);
+	  }
+      }
+    else if (type == RefinePartitionTypeV::SFC)
+      {
+	// Native space filling curve cutting, ParMetis is not needed
+	if (curMode != NETWORK) return false;
+	std::vector<unsigned long> keys;
+	std::vector<double> weights;
+	glb::console->printFlush<LOG_PEDANTIC>("(keys) ");
+	int keyBits=generateSFCKeys(keys,weights,weightPerCell,rootWeights);
+
+	glb::console->printFlush<LOG_PEDANTIC>("(cuts) ");
+	Partitioner::repartSFC(keys,weights,partition,keyBits,mpiCom);
+      }
+    else
+      {
+	glb::console->printFlush<LOG_PEDANTIC>("(graph) ");    
+	if (!generateParmetisGraph(p,type,tolerance,weightPerCell,rootWeights)) 
+	  return false;
     
-    glb::console->printFlush<LOG_PEDANTIC>("(metis) ");    
-    Partitioner::repart(p,type,partition);  
+	glb::console->printFlush<LOG_PEDANTIC>("(metis) ");    
+	Partitioner::repart(p,type,partition);  
+      }
 
     /*
     PRINT_SRC_INFO(LOG_STD_ALL);    
@@ -685,6 +874,45 @@ protected:
 	  //rootPool.recycle(rootArr[i]);
 	}  
     
+    // In tree free mode, the leaves cannot be retrieved from the roots so we need to
+    // scan them all. They are grouped by root, in the same order as sentRootPtrArr, and
+    // flatTreeSize stores the number of leaves of each sent root.
+    std::vector< std::vector<Element*> > flatLeaves;
+    std::vector< std::vector<unsigned int> > flatTreeSize;
+    if (treeFree)
+      {
+	std::vector<unsigned long> rootOffset(partition.size(),0);
+	flatLeaves.resize(nParts);
+	flatTreeSize.resize(nParts);
+	for (LeafIterator it=leafBegin;it!=leafEnd;++it)
+	  {
+	    Leaf *leaf=static_cast<Leaf*>(*it);
+	    long id=static_cast<Root*>(leaf->parent)->getLocalIndex();
+	    if (partition[id]!=myRank) rootOffset[id]++;
+	  }
+	for (long i=0;i<nParts;i++)
+	  {
+	    if (sentRootPtrArr[i].size()==0) continue;
+	    unsigned long n=0;
+	    flatTreeSize[i].resize(sentRootPtrArr[i].size());
+	    for (unsigned long j=0;j<sentRootPtrArr[i].size();j++)
+	      {
+		long id=sentRootPtrArr[i][j]->getLocalIndex();
+		flatTreeSize[i][j]=rootOffset[id];
+		rootOffset[id]=n;
+		n+=flatTreeSize[i][j];
+	      }
+	    flatLeaves[i].resize(n);
+	  }
+	for (LeafIterator it=leafBegin;it!=leafEnd;++it)
+	  {
+	    Leaf *leaf=static_cast<Leaf*>(*it);
+	    long id=static_cast<Root*>(leaf->parent)->getLocalIndex();
+	    if (partition[id]!=myRank) 
+	      flatLeaves[partition[id]][rootOffset[id]++]=*it;
+	  }
+      }
+
     // we will pop_back the identities when reassigning them, and this should 
     // be done from lowest to highest !
     std::reverse(freedGlobalIdentities.begin(),freedGlobalIdentities.end());
@@ -1126,9 +1354,18 @@ protected:
     std::vector< std::vector<CompactTreeData> > compactTree(toSend.size());     
     requests[3].resize(toSend.size());
     // compute how many nodes/leaves in the tree, build a compact tree data and Isend it
+    // (in tree free mode, the number of leaves of each root is all there is to send)
 #pragma omp parallel for num_threads(nThreads)
     for (unsigned long i=0;i<toSend.size();i++)
       {
+	if (treeFree)
+	  {
+	    compactTree[i].swap(flatTreeSize[rootExchange.sendRank[i]]);
+	    mpiCom->Isend(&compactTree[i][0],compactTree[i].size(),
+			  rootExchange.sendRank[i],&requests[3][i],mpiTagsStart_repart+4);
+	    continue;
+	  }
+
 	long index=rootExchange.sendRank[i];
 	char treeIndex=0;
 	long size=0;
@@ -1160,7 +1397,9 @@ protected:
     for (unsigned long i=0;i<rootExchange.sendRank.size();i++)
       {
 	const long index=rootExchange.sendRank[i];
-	for (unsigned long j=0;j<sentRootTreeArr[index].size();j++)
+	if (treeFree)
+	  leavesExchange.send[index].swap(flatLeaves[index]);
+	else for (unsigned long j=0;j<sentRootTreeArr[index].size();j++)
 	  {
 	    Node *node=sentRootTreeArr[index][j]->
 	      getLeavesRecycleNodes(leavesExchange.send[index],nodePool);
@@ -1190,11 +1429,16 @@ protected:
 
 	receivedCompactTree[index].resize(count);
 	mpiCom->Recv(&receivedCompactTree[index][0],count,source,mpiTagsStart_repart+4);
-	restoreCompactTree(receivedRootPtrArr[index],
-			   receivedCompactTree[index],
-			   receivedCompactTree[index].begin()+
-			   receivedCompactTree[index].back(),
-			   leavesExchange.receive[source]);
+	if (treeFree)
+	  restoreFlatTree(receivedRootPtrArr[index],
+			  receivedCompactTree[index],
+			  leavesExchange.receive[source]);
+	else
+	  restoreCompactTree(receivedRootPtrArr[index],
+			     receivedCompactTree[index],
+			     receivedCompactTree[index].begin()+
+			     receivedCompactTree[index].back(),
+			     leavesExchange.receive[source]);
 	
 	leavesExchange.receiveRank.push_back(source);
       }
@@ -1262,6 +1506,20 @@ protected:
       }
   }
 
+  // The leaves of a flat tree are all attached to its root, so each root is 
+  // the parent of as many received leaves as were sent for it.
+  template <class IT>
+  void restoreFlatTree(std::vector<Root*> &newRoots, 
+		       const std::vector<IT> &flatTreeSize,
+		       std::vector<AnyNodeBase *> &parents)
+  {
+    for (unsigned long i=0;i<newRoots.size();++i)
+      {
+	newRoots[i]->setChild(NULL);
+	parents.insert(parents.end(),flatTreeSize[i],newRoots[i]);
+      }
+  }
+
   long countCompactTreeLeaves(const std::vector<unsigned long> &compactTree)
   {
     long size=0;
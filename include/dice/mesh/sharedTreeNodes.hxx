@@ -171,6 +171,12 @@ namespace sharedTreeNodes {
 	      c->setParent(this);
 	      return 0;
 	    }
+	  else if (c->isLeaf())
+	    {
+	      // Tree free mode: all the leaves are directly attached to the root
+	      c->setParent(this);
+	      return 0;
+	    }
 	}
       else if (isNode())
 	{
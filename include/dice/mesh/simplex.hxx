@@ -577,6 +577,8 @@ public:
   // this function only takes care of the current simplex and the caller
   // must ensure consistency with the rest of the tesselation.
   // The local ID of newSimplex should be set correctly BEFORE calling this ...
+  // newNode is NULL for ghosts and shadows, and in tree free mode (newSimplex then 
+  // inherits the root of the current simplex as its parent).
   void splitSegment(const SegmentHandle &seg, Node *newNode, Vertex *newVertex, 
 		    Simplex *newSimplex, Segment **newSegment=NULL)
   {    
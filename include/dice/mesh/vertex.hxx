@@ -383,6 +383,25 @@ protected:
       flags &= ~VERTEX_FLAG_TAG;
   }
 
+  // Same as setTaggedF(true), but may be called concurrently on the same vertex
+  void setTaggedF_atomic()
+  {
+#pragma omp atomic
+    flags |= VERTEX_FLAG_TAG;
+  }
+
+  // Atomically tags the vertex, returns false if it was already tagged
+  bool testAndSetTaggedF()
+  {
+    Flag old;
+#pragma omp atomic capture
+    {
+      old = flags;
+      flags |= VERTEX_FLAG_TAG;
+    }
+    return !(old&VERTEX_FLAG_TAG);
+  }
+
   void setTagged2F(bool b=true)
   {
     if (b)
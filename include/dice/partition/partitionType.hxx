@@ -37,6 +37,7 @@ struct RefinePartitionTypeV {
 	     REFINE_KWAY=1, //!< Improve an already well balanced partionning using K-WAY
 	     ADAPTIVE=2, //!< Repartition to compensate imbalance due to successive refining / coarsening
 	     PH=3, //!< Peano-hilbert (position space)
+	     SFC=4, //!< Native weighted Peano-Hilbert curve cutting (no ParMetis)
 	     UNDEFINED=100};
 };
 
@@ -49,6 +50,7 @@ struct RefinePartitionTypeSelect : public TypeSelectT<RefinePartitionTypeV> {
     this->insert("REFINE_KWAY",RefinePartitionTypeV::REFINE_KWAY);
     this->insert("ADAPTIVE",RefinePartitionTypeV::ADAPTIVE);
     this->insert("PH",RefinePartitionTypeV::PH);
+    this->insert("SFC",RefinePartitionTypeV::SFC);
   }
   std::string name() {return "refinePartitionType";}
 };
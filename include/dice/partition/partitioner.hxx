@@ -2,6 +2,8 @@
 #define __PARTITIONER_HXX__
 
 #include <limits>
+#include <algorithm>
+#include <string.h>
 //#include <parmetis.h>
 
 #include "../dice_globals.hxx"
@@ -238,6 +240,193 @@ public:
     //return partition;
   }
 
+  /** \brief Cut a space filling curve into equal weight ranges, one per process.
+   *  Each process provides the keys of its local elements along the curve (in
+   *  [0,2^keyBits[) and their weights. The P-1 cut keys are found by a distributed
+   *  bisection over the key space, where each step computes the global weight
+   *  below the candidate cuts (i.e. a distributed weighted prefix sum). Only
+   *  reductions are needed, the keys themselves are never communicated, and the
+   *  result is deterministic. Elements that do not cross a cut keep their rank
+   *  as long as the current distribution is already ordered along the curve.
+   *  \param keys the local keys
+   *  \param weights the local weights
+   *  \param[out] partition the destination rank of each local element
+   *  \param keyBits the number of significant bits in the keys
+   *  \param com the MPI communicator
+   */
+  template <typename K>
+  static void repartSFC(const std::vector<K> &keys,
+			const std::vector<double> &weights,
+			std::vector<Index> &partition,
+			int keyBits,
+			MpiCommunication *com=glb::mpiComWorld)
+  {
+    const long nParts=com->size();
+    const unsigned long nLocal=keys.size();
+    partition.assign(nLocal,com->rank());
+    if (nParts<2) return;
+
+    // sort local elements along the curve and compute the local prefix sum
+    std::vector< std::pair<K,unsigned long> > sorted(nLocal);
+    for (unsigned long i=0;i<nLocal;++i)
+      sorted[i]=std::make_pair(keys[i],i);
+    std::sort(sorted.begin(),sorted.end());
+
+    std::vector<K> sortedKeys(nLocal);
+    std::vector<double> prefix(nLocal+1,0);
+    for (unsigned long i=0;i<nLocal;++i)
+      {
+	sortedKeys[i]=sorted[i].first;
+	prefix[i+1]=prefix[i]+weights[sorted[i].second];
+      }
+
+    const double totalWeight = com->sum(prefix.back());
+    const long nCuts=nParts-1;
+    std::vector<double> target(nCuts);
+    for (long k=0;k<nCuts;++k)
+      target[k]=(totalWeight*(k+1))/nParts;
+
+    // bisection : cut[k] is the smallest key such that the weight of all
+    // the elements with a lower key is larger than target[k]
+    std::vector<K> lo(nCuts,0);
+    std::vector<K> hi(nCuts,(keyBits<static_cast<int>(sizeof(K)*8))?
+		      (static_cast<K>(1)<<keyBits):std::numeric_limits<K>::max());
+    std::vector<double> below(nCuts);
+    for (int it=0;it<=keyBits;++it)
+      {
+	for (long k=0;k<nCuts;++k)
+	  {
+	    const K mid = lo[k]+(hi[k]-lo[k])/2;
+	    below[k]=prefix[std::lower_bound(sortedKeys.begin(),sortedKeys.end(),mid)-
+			    sortedKeys.begin()];
+	  }
+	com->sum(&below[0],nCuts);
+	for (long k=0;k<nCuts;++k)
+	  {
+	    const K mid = lo[k]+(hi[k]-lo[k])/2;
+	    if (below[k]>=target[k]) hi[k]=mid;
+	    else lo[k]=mid+1;
+	  }
+      }
+
+    // a key is sent to the rank whose range [cut[r-1],cut[r][ contains it
+    for (unsigned long i=0;i<nLocal;++i)
+      partition[i]=std::upper_bound(lo.begin(),lo.end(),keys[i])-lo.begin();
+  }
+
+  /** \brief Cut the global order of arbitrary keys into equal weight ranges, one 
+   *  per process, with a distributed sample sort. This is useful when the keys do 
+   *  not fit an integer type (e.g. PeanoHilbertT::HCode in 3D), so that repartSFC 
+   *  cannot bisect the key space. Each process sorts its elements and selects 
+   *  oversampling*P samples at regular intervals of its cumulative weight, each 
+   *  sample carrying the weight of the elements it represents. The samples are then 
+   *  gathered on all processes that all select the same P-1 splitters where the 
+   *  sorted samples' cumulative weight crosses multiples of 1/P of the total, so 
+   *  the result is deterministic. The imbalance is of the order of 1/oversampling.
+   *  \param keys the local keys. K must be a POD type with operator<
+   *  \param weights the local weights (all elements have weight 1 if empty)
+   *  \param[out] partition the destination rank of each local element
+   *  \param com the MPI communicator
+   *  \param oversampling the number of samples selected per process and partition
+   */
+  template <typename K>
+  static void repartSampleSort(const std::vector<K> &keys,
+			       const std::vector<double> &weights,
+			       std::vector<Index> &partition,
+			       MpiCommunication *com=glb::mpiComWorld,
+			       int oversampling=32)
+  {
+    struct Sample
+    {
+      K key;
+      double weight;
+      static bool compare(const Sample &a, const Sample &b)
+      {
+	return a.key<b.key;
+      }
+    };
+
+    const long nParts=com->size();
+    const unsigned long nLocal=keys.size();
+    partition.assign(nLocal,com->rank());
+    if (nParts<2) return;
+
+    std::vector<Sample> sorted(nLocal);
+    double localWeight=0;
+    for (unsigned long i=0;i<nLocal;++i)
+      {
+	sorted[i].key=keys[i];
+	sorted[i].weight=(weights.size())?weights[i]:1.0;
+	localWeight+=sorted[i].weight;
+      }
+    std::sort(sorted.begin(),sorted.end(),Sample::compare);
+
+    // Regular samples of the local cumulative weight. A sample carries the weight
+    // of all the elements since the previous one, including itself
+    const long nSamples=std::max(1,oversampling)*nParts;
+    std::vector<Sample> samples;
+    samples.reserve(nSamples);
+    double acc=0;
+    double emitted=0;
+    long next=1;
+    for (unsigned long i=0;(i<nLocal)&&(localWeight>0);++i)
+      {
+	acc+=sorted[i].weight;
+	if ((acc>=(localWeight*next)/nSamples)||(i+1==nLocal))
+	  {
+	    Sample smp=sorted[i];
+	    smp.weight=acc-emitted;
+	    samples.push_back(smp);
+	    emitted=acc;
+	    while ((next<nSamples)&&(acc>=(localWeight*next)/nSamples)) next++;
+	  }
+      }
+
+    // gather all the samples on every process (unused slots have a null weight)
+    const long slotSize=sizeof(Sample);
+    std::vector<unsigned char> buffer(nParts*nSamples*slotSize,0);
+    unsigned char *myBuffer=&buffer[com->rank()*nSamples*slotSize];
+    for (long i=0;i<nSamples;++i)
+      {
+	Sample smp;
+	if (i<(long)samples.size()) smp=samples[i];
+	else {smp.key=K();smp.weight=0;}
+	memcpy(myBuffer+i*slotSize,&smp,slotSize);
+      }
+    com->Allgather_inplace(buffer);
+
+    std::vector<Sample> allSamples;
+    allSamples.reserve(nParts*nSamples);
+    double totalWeight=0;
+    for (long i=0;i<nParts*nSamples;++i)
+      {
+	Sample smp;
+	memcpy(&smp,&buffer[i*slotSize],slotSize);
+	if (smp.weight<=0) continue;
+	allSamples.push_back(smp);
+	totalWeight+=smp.weight;
+      }
+    std::stable_sort(allSamples.begin(),allSamples.end(),Sample::compare);
+    
+    // splitters[k] is the key of the sample where the cumulative weight first reaches
+    // (k+1)/nParts of the total. Elements up to that key go to a rank <= k
+    std::vector<K> splitters;
+    splitters.reserve(nParts-1);
+    acc=0;
+    for (unsigned long i=0;(i<allSamples.size())&&((long)splitters.size()<nParts-1);++i)
+      {
+	acc+=allSamples[i].weight;
+	while (((long)splitters.size()<nParts-1)&&
+	       (acc>=(totalWeight*(splitters.size()+1))/nParts))
+	  splitters.push_back(allSamples[i].key);
+      }
+    if (splitters.empty()) return;
+
+    for (unsigned long i=0;i<nLocal;++i)
+      partition[i]=std::lower_bound(splitters.begin(),splitters.end(),keys[i])-
+	splitters.begin();
+  }
+
   /*
   template <class LMT>
   static long improve(const LMT *localMesh, std::vector<Index> &partition, double tolerance=1.05, MpiCommunication *com=glb::mpiComWorld)
@@ -115,6 +115,9 @@ public:
     BinaryReader::checkHeaderAndReport<LOG_ERROR,LOG_WARNING,SolverImplementation>
       (glb::console,reader,implVersion,true);
 
+    // The tree of split simplices is only needed to coarsen the mesh
+    if (!CoarseningStatus::isEnabled()) meshParams.treeFree=1;
+
     implementation = new SolverImplementation
       (meshParams,params,reader,manager,implVersion,mpiCom);
 
@@ -134,6 +137,8 @@ public:
     updateTimer  = glb::timerPool->pop("update");
     writeRestartTimer  = glb::timerPool->pop("writeRestart");
 
+    mpiCom->enableCallProfiler(params.profileMpiCalls);
+
     //const MeshParams& p = mesh->getParams();
 
     glb::console->print<LOG_INFO>("\n");
@@ -502,6 +507,67 @@ public:
     fclose(timingsFile);   
   }
 
+  // Write the MPI calls recorded by the profiler during the last time step, one line per
+  // phase and call type, and reset it.
+  void dumpMpiCallProfile()
+  {
+    static std::string profileFileName=
+      params.outputDir+std::string("timings/mpiCalls.txt");
+    static bool initialized=false;
+    FILE *profileFile;
+    internal::MpiCallProfiler *profiler=mpiCom->getCallProfiler();
+
+    if (!profiler->isEnabled()) return;
+
+    if (!initialized)
+      {	
+	if (mpiCom->size()>1)
+	  {
+	    char tmp[255];
+	    sprintf(tmp,"_R%4.4d",mpiCom->rank());
+	    profileFileName = profileFileName + std::string(tmp);
+	  }
+
+	//create the directory
+	if (mpiCom->rank()==0)
+	  myIO::makeDir(params.outputDir+std::string("timings/"));
+	mpiCom->barrier();
+	profileFileName = adaptFileName(profileFileName);
+
+	// Write header
+	profileFile = fopen(profileFileName.c_str(),"w");
+	if (profileFile==NULL) 
+	  {
+	    glb::console->print<LOG_ERROR>
+	      ("Opening file %s for writing.\n",
+	       profileFileName.c_str());
+	    exit(-1);
+	  }
+	fprintf(profileFile,"%s\n",
+		buildHeaderString("#stepIndex time phase call count elapsed bytes").c_str());
+	fclose(profileFile);
+	initialized=true; 
+      }
+
+    profileFile = fopen(profileFileName.c_str(),"a");
+    if (profileFile==NULL) 
+      {
+	glb::console->print<LOG_ERROR>
+	  ("Opening file %s for appending.\n",
+	   profileFileName.c_str());	
+	exit(-1);
+      }
+
+    for (internal::MpiCallProfiler::const_iterator it=profiler->begin();
+	 it!=profiler->end();++it)
+      fprintf(profileFile,"%ld %e %s %s %ld %e %e\n",
+	      curStep,curTime,
+	      it->first.first.c_str(),it->first.second.c_str(),
+	      it->second.count,it->second.time,it->second.bytes);
+    fclose(profileFile);
+    profiler->reset();
+  }
+
   void dumpStats()
   {
     static std::string statsFileName=
@@ -639,6 +705,7 @@ public:
 
 	stepTimer->start();		
 	// hlp::MakeConst is to ensure that the implementation will not change the value
+	mpiCom->setCallProfilerPhase("update");
 	updateTimer->start();
 	implementation->onNewTimeStep
 	  (hlp::makeConst(curStep),hlp::makeConst(curTime),deltaT);
@@ -647,6 +714,7 @@ public:
 #pragma omp parallel num_threads(glb::num_omp_threads)
 	{LIKWID_MARKER_START("Advance");}
 
+	mpiCom->setCallProfilerPhase("advance");
 	advanceTimer->start();
 	implementation->onAdvance();
 	el[1]=advanceTimer->stop();
@@ -663,6 +731,7 @@ public:
 #pragma omp parallel num_threads(glb::num_omp_threads)
 	{LIKWID_MARKER_START("Coarsen");}
 
+	mpiCom->setCallProfilerPhase("coarsen");
 	coarsenTimer->start();
 	long nCoarsened=coarsen();
 	implementation->afterCoarsen(nCoarsened);
@@ -674,6 +743,7 @@ public:
 #pragma omp parallel num_threads(glb::num_omp_threads)
 	{LIKWID_MARKER_START("Refine");}
 
+	mpiCom->setCallProfilerPhase("refine");
 	refineTimer->start();
 	long nRefined=refine();
 	implementation->afterRefine(nRefined);
@@ -685,17 +755,23 @@ public:
 #pragma omp parallel num_threads(glb::num_omp_threads)
 	{LIKWID_MARKER_START("Repart");}
 
+	mpiCom->setCallProfilerPhase("repart");
 	repartTimer->start();
 	bool repartStatus = repart();
 	implementation->afterRepart(repartStatus);
 	el[4]=repartTimer->stop();
+	mpiCom->setCallProfilerPhase("other");
 
 #pragma omp parallel num_threads(glb::num_omp_threads)
 	{LIKWID_MARKER_STOP("Repart");}	
 
 	elapsed = stepTimer->stop();
 
+	// Temporaries allocated from the scratch arenas cannot outlive a time step
+	glb::scratchArenas->reset();
+
 	dumpTimings();
+	dumpMpiCallProfile();
 	dumpStats();
 
 	if (glb::console->willPrint<LOG_INFO>())
@@ -733,6 +809,7 @@ public:
 				  mesh->getNCellsTotal(Mesh::NDIM)-mesh->getNCells(Mesh::NDIM));
 
 	    glb::memoryInspector->report<LOG_PEDANTIC>();
+	    glb::scratchArenas->report<LOG_PEDANTIC>();
 
 	    // glb::console->print<LOG_PEDANTIC>("New imbalance factor is %.3f.\n",
 	    // 				      mesh->getLoadImbalanceFactor());
@@ -874,17 +951,30 @@ public:
 	  {
 	    nStepsSinceLastCoarsen=1;
 	    result=mesh->coarsen(implementation);    
+	    return result;
 	  }
 	else nStepsSinceLastCoarsen++;	
       }
+    // coarsening also trims the ghost layer, so only trim when it did not run
+    trimGhostLayer();
     return result;
   }
 
   long coarsen(hlp::IsDisabled)
   {
+    trimGhostLayer();
     return 0;
   }
 
+  // Without coarsening, ghosts added by refinement are never removed
+  void trimGhostLayer()
+  {
+    if ((params.trimGhostsEvery>0)&&
+	(curStep>startStep)&&
+	((curStep%params.trimGhostsEvery)==0))
+      mesh->trimGhostLayer();
+  }
+
   long coarsen()
   {
     return coarsen(CoarseningStatus());
@@ -894,11 +984,31 @@ public:
   {
     //double weight=-1; // Use default weight
     bool force=false;
-    double weight=implementation->onCheckRepartLocalWeight(stepTimer->check(), force);
-    return mesh->repart(weight,force);
+    std::vector<double> rootWeights;
+    double weight=implementation->
+      onCheckRepartLocalWeight(stepTimer->check(), force, rootWeights);
+    RepartRootPartitioner rootPartitioner(implementation);
+    return mesh->repart(weight,force,glb::num_omp_threads,
+			rootWeights.empty()?NULL:&rootWeights,
+			&rootPartitioner);
   }
  
 private:
+  // Lets the implementation choose the new rank of each root of the mesh tree 
+  // through onRepartRootPartition() (see Mesh::repart())
+  struct RepartRootPartitioner
+  {
+    RepartRootPartitioner(SolverImplementation *impl):implementation(impl) {}
+    
+    bool operator()(const std::vector<double> &rootWeights, 
+		    std::vector<typename Mesh::PartitionerIndex> &partition)
+    {
+      return implementation->onRepartRootPartition(rootWeights,partition);
+    }
+    
+    SolverImplementation *implementation;
+  };
+
   Mesh *mesh;
   SolverImplementation *implementation;  
   BinaryReader *reader;
@@ -11,7 +11,7 @@ namespace slv {
   public:
     static std::string parserCategory() {return "solver";}
     static std::string classHeader() {return "solver_interface_params";}
-    static float classVersion() {return 0.15;}
+    static float classVersion() {return 0.16;}
     static float compatibleSinceClassVersion() {return 0.15;}
 
     double t0;
@@ -24,8 +24,10 @@ namespace slv {
     int noCoarsen;
     int restartEvery;
     int coarsenEvery;
+    int trimGhostsEvery;
     int resimulate;
     int resimulateEvery;
+    int profileMpiCalls;
     std::string outputDir;
     std::string timingsFileName;
     std::string statisticsFileName;
@@ -54,9 +56,11 @@ namespace slv {
       noRefine=false;
       noCoarsen=true;
       coarsenEvery=1;    
+      trimGhostsEvery=0;
       restartEvery=50;
       resimulate=0;
       resimulateEvery=0;
+      profileMpiCalls=0;
       outputDir = "";
       timingsFileName="timings.txt";
       statisticsFileName="statistics.txt";
@@ -105,6 +109,12 @@ namespace slv {
 		reader,PM::PARSER_FIRST,
 		"Force coarsening every N timesteps");
 	}    
+
+      trimGhostsEvery=paramsManager.
+	get("trimGhostsEvery",parserCategory(),trimGhostsEvery,
+	    reader,PM::PARSER_FIRST,
+	    "Trim the ghost/shadow layer every N timesteps when the mesh is not coarsened (0 to never trim, only matters with several MPI processes)",
+	    serializedVersion>0.155);
        
       restartEvery=paramsManager.
 	get("restartEvery",parserCategory(),restartEvery,
@@ -167,6 +177,10 @@ namespace slv {
       noRestart=parser->
 	get("noRestart",parserCategory(),noRestart,
 	    "Set to prevent from dumping any restart file.");
+
+      profileMpiCalls=parser->
+	get("profileMpiCalls",parserCategory(),profileMpiCalls,
+	    "Set to record the time spent and the data moved by each type of MPI call in each phase of the time steps (written to the 'timings' directory).");
     }
 
     template <class PP>
@@ -204,6 +218,10 @@ namespace slv {
 	    get("coarsenEvery",parserCategory(),coarsenEvery,
 		"Force coarsening every N timesteps");
 	}
+
+      trimGhostsEvery=paramsParser.
+	get("trimGhostsEvery",parserCategory(),trimGhostsEvery,
+	    "Trim the ghost/shadow layer every N timesteps when the mesh is not coarsened (0 to never trim, only matters with several MPI processes)");
     
       restartEvery=paramsParser.
 	get("restartEvery",parserCategory(),restartEvery,
@@ -252,6 +270,10 @@ namespace slv {
       noRestart=paramsParser.
 	get("noRestart",parserCategory(),noRestart,
 	    "Prevent from dumping any restart file.");
+
+      profileMpiCalls=paramsParser.
+	get("profileMpiCalls",parserCategory(),profileMpiCalls,
+	    "Record the time spent and the data moved by each type of MPI call in each phase of the time steps.");
     }
   private:
     // The version of the class from the file we read from
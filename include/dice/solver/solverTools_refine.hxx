@@ -106,6 +106,66 @@ namespace slv {
       return CheckRefineReturnType(score,segIndex);
     }
 
+
+    /** 
+     * \brief Identifies the segment to split following a predefined bisection order,
+     * and return its index and square length in lagrangian coordinates. The longest 
+     * segment in lagrangian coordinates (i.e. using initCoords) is selected, ties being 
+     * broken by selecting the segment with the oldest vertices and then by comparing the
+     * vertices global identities, so that the result does not depend on the order of the
+     * vertices in the simplex and is consistent over different MPI processes.
+     * For meshes initially tesselated with Kuhn simplices, this reproduces Maubach's 
+     * bisection, so that simplices shapes remain bounded as long as only these segments 
+     * are split (see MeshT::refine and checkRefine_predefinedOrder()).
+     */
+    template <class M>
+    typename M::CheckRefineReturnType 
+    predefinedBisectionSegment(typename M::Simplex *s, 
+			       const typename M::GeometricProperties *geometry)
+    {
+      typedef typename M::CheckRefineReturnType CheckRefineReturnType;
+      typedef typename M::SegmentHandle SegmentHandle;
+      typedef typename M::Simplex Simplex;
+      typedef typename M::Vertex Vertex;
+      typedef typename M::Coord Coord;
+      typedef typename Vertex::GlobalIdentity GlobalIdentity;
+
+      int segIndex=-1;
+      double score=-1;
+      long generation=0;
+      GlobalIdentity id[2];
+    
+      for (int i=0;i<Simplex::NSEG;i++)
+	{
+	  SegmentHandle seg=s->getSegmentHandle(i);
+	  Vertex *v0=seg->getVertex(0);
+	  Vertex *v1=seg->getVertex(1);
+	  double v=geometry->template 
+	    distance2<Coord,M::NDIM_W>(v0->initCoords.getPointer(),
+				       v1->initCoords.getPointer());
+	  long g=std::max(v0->getGeneration().rank(),v1->getGeneration().rank());
+	  GlobalIdentity a=v0->getGlobalIdentity();
+	  GlobalIdentity b=v1->getGlobalIdentity();
+	  if (b<a) std::swap(a,b);
+
+	  bool better;
+	  if (v!=score) better = (v>score);
+	  else if (g!=generation) better = (g<generation);
+	  else if (a!=id[0]) better = (a<id[0]);
+	  else better = (b<id[1]);
+
+	  if (better)
+	    {
+	      score=v;
+	      segIndex=i;
+	      generation=g;
+	      id[0]=a;
+	      id[1]=b;
+	    }
+	}
+      
+      return CheckRefineReturnType(score,segIndex);
+    }
     
     template <class M>
     std::pair<double,int>
@@ -302,6 +362,84 @@ namespace slv {
       else return std::make_pair(result,index);
     }
 
+    /** 
+     * \brief Batched version of poincareInvariantWithSegTracers_order1 that only 
+     * computes the value of the invariant (not the segment index) for \a n simplices.
+     * The coordinates are first gathered into structure of arrays blocks so that the 
+     * invariants are computed for a whole block at once in vectorizable loops.
+     * \param simplices an array of \a n pointers to simplices
+     * \param n the number of simplices
+     * \param geometry the geometric properties of the mesh
+     * \param[out] result the value of the invariant for each simplex
+     */
+    template <class M, class S>
+    void poincareInvariantWithSegTracers_order1_batch
+    (S * const *simplices, long n,
+     const typename M::GeometricProperties *geometry, double *result)
+    {
+      typedef typename M::SegmentHandle SegmentHandle;
+      typedef typename M::Simplex Simplex;
+      typedef typename M::Coord   Coord;
+
+      static const int NDIM = M::NDIM;
+      static const int NDIM_W = M::NDIM_W;
+      static const int NSEG = Simplex::NSEG;
+      static const long BLOCK = 32;
+      
+      // SoA storage : segments vectors, segments origin and tracers
+      Coord seg[NSEG][NDIM_W][BLOCK];
+      Coord org[NSEG][NDIM_W][BLOCK];
+      Coord trc[NSEG][NDIM_W][BLOCK];
+      double res[BLOCK];
+
+      for (long start=0;start<n;start+=BLOCK)
+	{
+	  const long nb=std::min(BLOCK,n-start);
+
+	  // Gather
+	  for (long b=0;b<nb;++b)
+	    {
+	      S *simplex=simplices[start+b];
+	      const Coord *t=simplex->segTracers.getPointer();
+	      for (int sid=0;sid<NSEG;++sid)
+		{
+		  SegmentHandle sh=simplex->getSegmentHandle(sid);
+		  const Coord *c0=sh->getVertex(0)->getCoordsPtr();
+		  const Coord *c1=sh->getVertex(1)->getCoordsPtr();
+		  for (int j=0;j<NDIM_W;++j)
+		    {
+		      seg[sid][j][b]=geometry->correctCoordsDiff(c1[j]-c0[j],j);
+		      org[sid][j][b]=c0[j];
+		      trc[sid][j][b]=t[sid*NDIM_W+j];
+		    }
+		}
+	    }
+	  
+	  // Compute, one (segment,tracer) pair at a time for the whole block
+	  std::fill_n(res,nb,0);
+	  for (int sid=0;sid<NSEG;++sid)
+	    for (int sid2=0;sid2<NSEG;++sid2)
+	      {
+		if (sid2==sid) continue;
+		for (long b=0;b<nb;++b)
+		  {
+		    double pi=0;
+		    for (int i=0;i<NDIM;++i)
+		      {
+			Coord dx=geometry->correctCoordsDiff(trc[sid2][i][b]-org[sid][i][b],i);
+			Coord dv=geometry->correctCoordsDiff
+			  (trc[sid2][NDIM+i][b]-org[sid][NDIM+i][b],NDIM+i);
+			pi+=seg[sid][i][b]*dv - dx*seg[sid][NDIM+i][b];
+		      }
+		    pi=fabs(pi);
+		    res[b]=(pi>res[b])?pi:res[b];
+		  }
+	      }
+	  
+	  std::copy_n(res,nb,result+start);
+	}
+    }
+
     template <class M>
     typename M::CheckRefineReturnType 
     poincareInvariantFromNeighbors(const typename M::Simplex::Neighborhood &nb, 
@@ -1,9 +1,107 @@
 #ifndef __MPI_CALL_TIMER_INTERFACE_HXX__
 #define __MPI_CALL_TIMER_INTERFACE_HXX__
 
+#include <map>
+#include <string>
+#include <utility>
+
+/**
+ * @file
+ * @brief  A profiler recording the time spent and the amount of data moved by
+ * MpiCommunication calls, sorted by solver phase.
+ * @author Thierry Sousbie
+ */
+
+#include "../../../internal/namespace.header"
+
 namespace internal
 {
-  
+  /**
+   * \brief Accumulates the number of calls, the time spent and the number of bytes
+   * sent (or received for receive operations) for each wrapped MPI call, keyed by
+   * the current phase (e.g. "refine", "repart", "poisson", ...) and the name of the
+   * call. Only calls made from the origin thread of the MpiCommunication object are
+   * recorded, just like for its timers. Recording is disabled by default.
+   */
+  class MpiCallProfiler
+  {
+  public:
+    struct Record
+    {
+      Record():count(0),time(0),bytes(0) {}
+      long count;
+      double time;
+      double bytes;
+    };
+
+    typedef std::pair<std::string,std::string> Key; // (phase,call)
+    typedef std::map<Key,Record> RecordMap;
+    typedef RecordMap::const_iterator const_iterator;
+
+    MpiCallProfiler():
+      enabled(false),
+      phase("other")
+    {}
+
+    void enable(bool value=true) {enabled=value;}
+    bool isEnabled() const {return enabled;}
+
+    //! set the current phase and return the previous one so that it can be restored
+    std::string setPhase(const std::string &newPhase)
+    {
+      std::string old=phase;
+      phase=newPhase;
+      return old;
+    }
+
+    const std::string &getPhase() const {return phase;}
+
+    void record(const char *call, double time, double bytes)
+    {
+      if (!enabled) return;
+      Record &r=records[Key(phase,call)];
+      r.count++;
+      r.time+=time;
+      r.bytes+=bytes;
+    }
+
+    const_iterator begin() const {return records.begin();}
+    const_iterator end() const {return records.end();}
+    bool empty() const {return records.empty();}
+
+    //! forget all the records (e.g. at the end of each time step)
+    void reset() {records.clear();}
+
+  private:
+    bool enabled;
+    std::string phase;
+    RecordMap records;
+  };
+
+  /**
+   * \brief Sets the phase of a profiler for the lifetime of the object, the
+   * previous phase is restored on destruction.
+   */
+  class MpiCallProfilerPhase
+  {
+  public:
+    MpiCallProfilerPhase(MpiCallProfiler *p, const std::string &phase):
+      profiler(p)
+    {
+      previous=profiler->setPhase(phase);
+    }
+
+    ~MpiCallProfilerPhase()
+    {
+      profiler->setPhase(previous);
+    }
+
+  private:
+    MpiCallProfiler *profiler;
+    std::string previous;
+  };
+
 }
 
+#include "../../../internal/namespace.footer"
 #endif
@@ -0,0 +1,131 @@
+#ifndef __MPI_PROGRESS_THREAD_HXX__
+#define __MPI_PROGRESS_THREAD_HXX__
+
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#include <sys/time.h>
+#include <errno.h>
+#endif
+
+#include "../myMpi.hxx"
+
+/**
+ * @file
+ * @brief  A thread that drives the progress of pending non blocking MPI
+ * communications in the background.
+ * @author Thierry Sousbie
+ */
+
+#include "../../../internal/namespace.header"
+
+namespace internal
+{
+  /**
+   * \brief Most MPI libraries only progress non blocking communications (e.g. the
+   * rendezvous protocol of large messages) while the process is inside an MPI call.
+   * This thread periodically enters the MPI library on a private communicator so
+   * that transfers started with Isend/Irecv complete while the computing threads
+   * work, instead of only when they eventually call Wait. This requires MPI to be
+   * initialized with MPI_THREAD_MULTIPLE and pthreads support.
+   */
+  class MpiProgressThread
+  {
+  public:
+    MpiProgressThread():
+      running(false)
+    {}
+
+    ~MpiProgressThread()
+    {
+      stop();
+    }
+
+    bool isRunning() const {return running;}
+
+#if defined(USE_MPI) && defined(USE_PTHREADS)
+    /** \brief start the thread, polling MPI every \a period microseconds. This
+     * is a collective call over \a com.
+     * \return false if the thread could not be started
+     */
+    bool start(MPI_Comm com, long period)
+    {
+      if (running) return true;
+      MPI_Comm_dup(com,&progressCom);
+      periodUs=(period>0)?period:1;
+      stopRequested=false;
+      pthread_mutex_init(&mutex,NULL);
+      pthread_cond_init(&cond,NULL);
+      if (pthread_create(&thread,NULL,&MpiProgressThread::run,this)!=0)
+	{
+	  pthread_cond_destroy(&cond);
+	  pthread_mutex_destroy(&mutex);
+	  MPI_Comm_free(&progressCom);
+	  return false;
+	}
+      running=true;
+      return true;
+    }
+
+    //! stop the thread (not collective)
+    void stop()
+    {
+      if (!running) return;
+      pthread_mutex_lock(&mutex);
+      stopRequested=true;
+      pthread_cond_signal(&cond);
+      pthread_mutex_unlock(&mutex);
+      pthread_join(thread,NULL);
+      pthread_cond_destroy(&cond);
+      pthread_mutex_destroy(&mutex);
+      MPI_Comm_free(&progressCom);
+      running=false;
+    }
+
+  private:
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool stopRequested;
+    long periodUs;
+    MPI_Comm progressCom;
+
+    static void *run(void *arg)
+    {
+      MpiProgressThread *me=static_cast<MpiProgressThread*>(arg);
+
+      pthread_mutex_lock(&me->mutex);
+      while (!me->stopRequested)
+	{
+	  pthread_mutex_unlock(&me->mutex);
+	  // nothing is ever sent on progressCom, but entering the library lets it
+	  // progress all the pending communications of the process
+	  int flag;
+	  MPI_Iprobe(MPI_ANY_SOURCE,MPI_ANY_TAG,me->progressCom,&flag,MPI_STATUS_IGNORE);
+	  pthread_mutex_lock(&me->mutex);
+	  if (me->stopRequested) break;
+
+	  struct timeval now;
+	  struct timespec until;
+	  gettimeofday(&now,NULL);
+	  long usec=now.tv_usec+me->periodUs;
+	  until.tv_sec=now.tv_sec+usec/1000000;
+	  until.tv_nsec=(usec%1000000)*1000;
+	  int rc=0;
+	  while ((!me->stopRequested)&&(rc!=ETIMEDOUT))
+	    rc=pthread_cond_timedwait(&me->cond,&me->mutex,&until);
+	}
+      pthread_mutex_unlock(&me->mutex);
+      return NULL;
+    }
+#else
+    bool start(MPI_Comm com, long period) {return false;}
+    void stop() {}
+#endif
+
+  private:
+    bool running;
+  };
+}
+
+#include "../../../internal/namespace.footer"
+#endif
@@ -0,0 +1,132 @@
+#ifndef __MPI_CHUNKED_EXCHANGE_HXX__
+#define __MPI_CHUNKED_EXCHANGE_HXX__
+
+#include <vector>
+#include <algorithm>
+
+#include "../../tools/MPI/myMpi.hxx"
+#include "../../tools/MPI/mpiCommunication.hxx"
+
+/**
+ * @file
+ * @brief  Point to point exchange of large arrays of structured data split in
+ * messages of bounded size.
+ * @author Thierry Sousbie
+ */
+
+#include "../../internal/namespace.header"
+
+/**
+ * \class MpiChunkedExchangeT
+ * \brief Sends arrays of structured data to a set of destination processes as
+ * a stream of messages of at most chunkSize elements, all with the same tag.
+ * A stream ends with the first message that contains less than chunkSize
+ * elements (possibly none), so the receiver does not need to know the size of
+ * the streams in advance. Each chunk is sent as soon as it is packed, and the
+ * receiver unpacks the chunks in the order they arrive, whatever their source.
+ * \tparam T the type of the exchanged structures (described by an MPI_Datatype)
+ */
+template <typename T>
+class MpiChunkedExchangeT
+{
+public:
+  typedef MpiChunkedExchangeT<T> MyType;
+
+  /** \param com the communicator
+   *  \param type the MPI type describing T
+   *  \param tag the tag used by all the messages of the exchange
+   *  \param nDestinations the number of destinations we will send data to
+   *  \param chunkSize the maximum number of elements per message (<=0 for unlimited)
+   */
+  MpiChunkedExchangeT(MpiCommunication *com, MPI_Datatype type, int tag,
+		      long nDestinations, long chunkSize):
+    mpiCom(com),
+    dataType(type),
+    mpiTag(tag),
+    chunk(chunkSize),
+    requests(nDestinations)
+  {
+    if (chunk<=0) chunk=-1;
+  }
+
+  ~MpiChunkedExchangeT()
+  {
+    wait();
+  }
+
+  /** \brief Pack and send count elements to process rank. The buffer is resized
+   *  to count and filled chunk by chunk by calling packer(T *out, long n), which
+   *  must write the next n elements of the stream to out. Each chunk is sent
+   *  immediately after it was packed. The buffer must not be modified until wait()
+   *  returns. Different destIndex may be sent concurrently from different threads.
+   */
+  template <class P>
+  void send(long destIndex, long rank, std::vector<T> &buffer, long count,
+	    P &packer)
+  {
+    buffer.resize(count);
+    requests[destIndex].reserve(nChunks(count));
+
+    long start=0;
+    long n=0;
+    do {
+      n=(chunk<0)?count:std::min(chunk,count-start);
+      if (n>0) packer(&buffer[start],n);
+      requests[destIndex].push_back(MPI_Request());
+      mpiCom->IsendMpiType((n>0)?&buffer[start]:(T*)NULL,n,dataType,rank,
+			   &requests[destIndex].back(),mpiTag);
+      start+=n;
+    } while (n==chunk);
+  }
+
+  /** \brief Receive the streams sent by nSources processes. For each received
+   *  chunk, unpacker.getBuffer(int source, long n) must return an array able to
+   *  store n elements, and unpacker(int source, T *data, long n) is then called
+   *  to process the chunk once it was received in that array.
+   */
+  template <class U>
+  void receive(long nSources, U &unpacker) const
+  {
+    long nDone=0;
+    while (nDone<nSources)
+      {
+	int count=0;
+	MPI_Datatype type=dataType;
+	int source=mpiCom->ProbeCount(count,type,mpiTag);
+	T *data=unpacker.getBuffer(source,count);
+	mpiCom->RecvMpiType(data,count,dataType,source,mpiTag);
+	if (count>0) unpacker(source,data,count);
+	if (count!=chunk) nDone++;
+      }
+  }
+
+  //! wait for all the sends to complete
+  void wait()
+  {
+    for (unsigned long i=0;i<requests.size();++i)
+      {
+	for (unsigned long j=0;j<requests[i].size();++j)
+	  mpiCom->Wait(&requests[i][j]);
+	requests[i].clear();
+      }
+  }
+
+  //! the maximum number of elements in a message (-1 if unlimited)
+  long getChunkSize() const {return chunk;}
+
+private:
+  MpiCommunication *mpiCom;
+  MPI_Datatype dataType;
+  int mpiTag;
+  long chunk;
+  std::vector< std::vector<MPI_Request> > requests;
+
+  long nChunks(long count) const
+  {
+    if (chunk<0) return 1;
+    return count/chunk+1;
+  }
+};
+
+#include "../../internal/namespace.footer"
+#endif
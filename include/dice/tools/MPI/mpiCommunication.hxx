@@ -18,6 +18,8 @@
 #include "../../tools/OMP/openMP_interface.hxx"
 #include "./myMpi.hxx"
 #include "./mpiDataType.hxx"
+#include "./internal/mpiCallTimerInterface.hxx"
+#include "./internal/mpiProgressThread.hxx"
 
 #include "../../internal/namespace.header"
 
@@ -106,32 +108,47 @@ namespace internal {
   class MpiCallTimerT
   {
   public:
-    MpiCallTimerT(TimerPool::Timer *t, int th=0):
+    MpiCallTimerT(TimerPool::Timer *t, int th=0, 
+		  MpiCallProfiler *p=NULL, const char *c=NULL, double b=0):
       timer(t),
-      thread(th)
+      thread(th),
+      profiler(p),
+      call(c),
+      bytes(b)
     {
       if (omp_get_thread_num()==thread) timer->start();
     }
 
     ~MpiCallTimerT()
     {
-      if (omp_get_thread_num()==thread) timer->stop();
+      if (omp_get_thread_num()==thread) 
+	{
+	  double elapsed=timer->stop();
+	  if (profiler!=NULL) profiler->record(call,elapsed,bytes);
+	}
     }
   private:
     TimerPool::Timer *timer;
     int thread;
+    MpiCallProfiler *profiler;
+    const char *call;
+    double bytes;
   };
 
   template <>
   class MpiCallTimerT<true>
   {
     public:
-    MpiCallTimerT(TimerPool::Timer *t, int th=0){}
+    MpiCallTimerT(TimerPool::Timer *t, int th=0, 
+		  MpiCallProfiler *p=NULL, const char *c=NULL, double b=0){}
   };
 }
 
 
 class MpiCommunication {
+public:
+  //! Methods used to renumber the processes at startup (see reorderRanks())
+  enum RankReordering {REORDER_NONE=0, REORDER_NODE=1, REORDER_GRAPH=2};
   
 private:
   static const int maxReservedTags= (MPID_TAG_UB>>1);  
@@ -151,6 +168,8 @@ private:
   TimerPool::Timer *localComTimer;
   TimerPool::Timer *globalComTimer;
   TimerPool::Timer *barrierTimer;
+  mutable internal::MpiCallProfiler callProfiler;
+  internal::MpiProgressThread progressThread;
 
   std::list<MPI_Request> pendingRequests;
 #ifdef USE_MPI
@@ -159,6 +178,28 @@ private:
   typedef internal::MpiOmpLockChekerT<false> MpiOmpLockChecker;
   mutable MpiOmpLocker locker;
 
+  // Node local communicator (i.e. processes sharing memory), created on demand
+  MPI_Comm nodeCom;
+  int myNodeRank;
+  int myNodeSize;
+  std::vector<int> nodeLeader; // rank of the leader of the node of each process
+
+  // Deferred reductions (see deferReduction()) : values registered since the last call
+  // to startDeferredReductions(), and values currently being reduced. Each value is 
+  // stored in the buffers as a pair (operation code, value).
+  struct DeferredReduction
+  {
+    void *ptr;
+    void (*writeBack)(void *, double);
+  };
+  std::vector<DeferredReduction> deferredRegistered;
+  std::vector<double> deferredRegisteredBuffer;
+  std::vector<DeferredReduction> deferredInFlight;
+  std::vector<double> deferredInFlightBuffer;
+  MPI_Request deferredRequest;
+  MPI_Op deferredOp;
+  MPI_Datatype deferredType;
+
 private:
   
   void initCom(MPI_Comm myCom)
@@ -166,6 +207,42 @@ private:
     com=myCom;
     MPI_Comm_rank(com, &myRank);
     MPI_Comm_size(com, &nProcs);
+    nodeCom=MPI_COMM_NULL;
+    myNodeRank=0;
+    myNodeSize=1;
+    nodeLeader.clear();
+  }
+
+  // number of bytes in count elements of type dataType (only if profiling)
+  double countBytes(long count, MPI_Datatype dataType) const
+  {
+    if (!callProfiler.isEnabled()) return 0;
+    int sz;
+    MPI_Type_size(dataType,&sz);
+    return static_cast<double>(count)*sz;
+  }
+
+  double countBytes(const int *counts, MPI_Datatype dataType, long n) const
+  {
+    if (!callProfiler.isEnabled()) return 0;
+    double result=0;
+    for (long i=0;i<n;++i) result+=counts[i];
+    return result*countBytes(1,dataType);
+  }
+
+  double countBytes(const int *counts, const MPI_Datatype *dataTypes, long n) const
+  {
+    if (!callProfiler.isEnabled()) return 0;
+    double result=0;
+    for (long i=0;i<n;++i) 
+      if (counts[i]>0) result+=countBytes(counts[i],dataTypes[i]);
+    return result;
+  }
+
+  double countBytes(const std::vector<int> &counts, 
+		    const std::vector<MPI_Datatype> &dataTypes) const
+  {
+    return (counts.size())?countBytes(&counts[0],&dataTypes[0],counts.size()):0;
   }
 
   void init(int *argc, char ***argv)
@@ -180,7 +257,7 @@ private:
 	finalize=true;
 	deleteCom=false;
 
-#ifdef USE_OPENMP
+#if defined(USE_OPENMP) || defined(USE_PTHREADS)
 	int required=MPI_THREAD_MULTIPLE;
 	int provided;
 	MPI_Init_thread(argc, argv, required, &provided);
@@ -239,6 +316,8 @@ public:
     originThreadId = omp_get_thread_num();    
     finalize=false;
     deleteCom=false;
+    deferredRequest=MPI_REQUEST_NULL;
+    deferredOp=MPI_OP_NULL;
     setCom(com_);
     globalComTimer = glb::timerPool->pop("MPI_globalCom");
     localComTimer = glb::timerPool->pop("MPI_localCom");
@@ -252,6 +331,8 @@ public:
     reservedTagsStart(100)
   {
     originThreadId = omp_get_thread_num();        
+    deferredRequest=MPI_REQUEST_NULL;
+    deferredOp=MPI_OP_NULL;
     init(argc,argv);
     globalComTimer = glb::timerPool->pop("MPI_globalCom",false);
     localComTimer = glb::timerPool->pop("MPI_localCom",false);
@@ -265,6 +346,13 @@ public:
 
   ~MpiCommunication()
   {
+    progressThread.stop();
+    if (deferredOp!=MPI_OP_NULL)
+      {
+	MPI_Op_free(&deferredOp);
+	MPI_Type_free(&deferredType);
+      }
+    if (nodeCom!=MPI_COMM_NULL) MPI_Comm_free(&nodeCom);
     if (deleteCom) MPI_Comm_free(&com);
     if (finalize) MPI_Finalize();   
   }
@@ -273,7 +361,7 @@ public:
   {
     // finalize=false;
     // deleteCom=false;
-#ifdef USE_OPENMP
+#if defined(USE_OPENMP) || defined(USE_PTHREADS)
     MPI_Query_thread(&threadSupport);
 #else
     threadSupport=0;
@@ -317,7 +405,8 @@ public:
     tmp[0]=val;
     tmp[1]=-val;
     
-    MpiCallTimer timer(UseAsBarrier?barrierTimer:globalComTimer,originThreadId); 
+    MpiCallTimer timer(UseAsBarrier?barrierTimer:globalComTimer,originThreadId,
+		       &callProfiler,"minMax",2*sizeof(T)); 
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Allreduce(MPI_IN_PLACE, tmp, 2, MPI_Type<T>::get(), MPI_MIN, com);
@@ -329,7 +418,8 @@ public:
   template <typename T, bool UseAsBarrier=false>
   std::pair< std::pair<T,T> , T> minMaxSum(const T &val) const
   {
-    MpiCallTimer timer(UseAsBarrier?barrierTimer:globalComTimer,originThreadId);      
+    MpiCallTimer timer(UseAsBarrier?barrierTimer:globalComTimer,originThreadId,
+		       &callProfiler,"minMaxSum",3*sizeof(T));      
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Op op;
@@ -350,7 +440,8 @@ public:
   T max(const T &val) const
   {
     T tmp=val;
-    MpiCallTimer timer(UseAsBarrier?barrierTimer:globalComTimer,originThreadId);
+    MpiCallTimer timer(UseAsBarrier?barrierTimer:globalComTimer,originThreadId,
+		       &callProfiler,"max",sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Allreduce(MPI_IN_PLACE, &tmp, 1, MPI_Type<T>::get(), MPI_MAX, com);
@@ -361,7 +452,8 @@ public:
   template <typename T>
   void max(T* val, long N) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"max",N*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Allreduce(MPI_IN_PLACE, val, N, MPI_Type<T>::get(), MPI_MAX, com);
@@ -372,7 +464,8 @@ public:
   T min(const T &val) const
   {
     T tmp=val;
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"min",sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Allreduce(MPI_IN_PLACE, &tmp, 1, MPI_Type<T>::get(), MPI_MIN, com);
@@ -383,7 +476,8 @@ public:
   template <typename T>
   void min(T* val, long N) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"min",N*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Allreduce(MPI_IN_PLACE, val, N, MPI_Type<T>::get(), MPI_MIN, com); 
@@ -394,7 +488,8 @@ public:
   T sum(const T &val) const
   {
     T tmp=val;
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"sum",sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Allreduce(MPI_IN_PLACE, &tmp, 1, MPI_Type<T>::get(), MPI_SUM, com);
@@ -405,7 +500,8 @@ public:
   template <typename T>
   void sum(T* val, long N) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"sum",N*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Allreduce(MPI_IN_PLACE, val, N, MPI_Type<T>::get(), MPI_SUM, com);   
@@ -414,7 +510,8 @@ public:
 
   void barrier() const
   {
-    MpiCallTimer timer(barrierTimer,originThreadId);
+    MpiCallTimer timer(barrierTimer,originThreadId,
+		       &callProfiler,"barrier",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Barrier(com);    
@@ -429,7 +526,8 @@ public:
   template <class Container, bool UseAsBarrier=false>
   int Bcast(Container &buffer, int root=0,long count=-1) const
   {
-    MpiCallTimer timer(UseAsBarrier?barrierTimer:globalComTimer,originThreadId);
+    MpiCallTimer timer(UseAsBarrier?barrierTimer:globalComTimer,originThreadId,
+		       &callProfiler,"Bcast",((count<0)?buffer.size():count)*sizeof(typename Container::value_type));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     //MpiCallTimer timer(globalComTimer,originThreadId);
     if (count<0) count=buffer.size();
@@ -442,7 +540,8 @@ public:
   template <typename T, bool UseAsBarrier=false>
   int Bcast(T* buffer, int root=0, long count=1) const
   {    
-    MpiCallTimer timer(UseAsBarrier?barrierTimer:globalComTimer,originThreadId);
+    MpiCallTimer timer(UseAsBarrier?barrierTimer:globalComTimer,originThreadId,
+		       &callProfiler,"Bcast",count*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     //MpiCallTimer timer(globalComTimer,originThreadId);
     int res=MPI_Bcast(buffer,count,MPI_Type<T>::get(),root,com);
@@ -453,7 +552,8 @@ public:
   template <typename T>
   int Gather(T *sendBuffer, long sendCount, T* rcvBuffer, long rcvCount, long root) const
   {   
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Gather",sendCount*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     return MPI_Gather(sendBuffer,sendCount,MPI_Type<T>::get(),
 		      rcvBuffer,rcvCount,MPI_Type<T>::get(),
@@ -483,7 +583,8 @@ public:
   int Recv(T* rcv, long count, long node, int tag=MPI_ANY_TAG) const
   {
     MPI_Status status;
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Recv",count*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Recv(rcv,count,MPI_Type<T>::get(),node,tag,com,&status);
     
@@ -493,7 +594,8 @@ public:
   template <typename T>
   int Send(T* snd, long count, long node, int tag=0) const
   {  
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Send",count*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Send(snd,count,MPI_Type<T>::get(),node,tag,com);	  
     
@@ -519,7 +621,8 @@ public:
   template <typename T>
   int Irecv(T* rcv, long count, long node, MPI_Request *req, int tag=MPI_ANY_TAG) const
   { 
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Irecv",count*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     return MPI_Irecv(rcv,count,MPI_Type<T>::get(),node,tag,com,req);
   }
@@ -527,7 +630,8 @@ public:
   template <typename T>
   int Isend(T* snd, long count, long node, MPI_Request *req, int tag=0) const
   {   
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Isend",count*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     return  MPI_Isend(snd,count,MPI_Type<T>::get(),node,tag,com,req);	  
   }
@@ -538,7 +642,8 @@ public:
 		  int tag=MPI_ANY_TAG) const
   {
     MPI_Status status;
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Recv",countBytes(count,dataType));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Recv(rcv,count,dataType,node,tag,com,&status);
     
@@ -548,7 +653,8 @@ public:
   template <typename T>
   int SendMpiType(T* snd, long count, MPI_Datatype dataType, long node, int tag=0) const
   {  
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Send",countBytes(count,dataType));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Send(snd,count,dataType,node,tag,com);
     
@@ -559,7 +665,8 @@ public:
   int IrecvMpiType(T* rcv, long count, MPI_Datatype dataType, long node, 
 		   MPI_Request *req, int tag=MPI_ANY_TAG) const
   {
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Irecv",countBytes(count,dataType));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Irecv(rcv,count,dataType,node,tag,com,req);
     return res;
@@ -569,11 +676,146 @@ public:
   int IsendMpiType(T* snd, long count, MPI_Datatype dataType,long node, 
 		   MPI_Request *req, int tag=0) const
   {  
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Isend",countBytes(count,dataType));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Isend(snd,count,dataType,node,tag,com,req);	  
     return res;
   }
+
+  // persistent requests, started with Startall and released with Request_free
+  template <typename T>
+  int Recv_init(T* rcv, long count, long node, MPI_Request *req, 
+		int tag=MPI_ANY_TAG) const
+  { 
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Recv_init",0);
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    return MPI_Recv_init(rcv,count,MPI_Type<T>::get(),node,tag,com,req);
+  }
+
+  template <typename T>
+  int Send_init(T* snd, long count, long node, MPI_Request *req, int tag=0) const
+  {   
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Send_init",0);
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    return MPI_Send_init(snd,count,MPI_Type<T>::get(),node,tag,com,req);
+  }
+
+  int Startall(std::vector<MPI_Request> &req) const
+  {
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Startall",0);
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    return MPI_Startall(req.size(),&req[0]);
+  }
+
+  int Request_free(MPI_Request *req) const
+  {
+    // persistent requests may be owned by objects destroyed after MPI_Finalize
+    int finalized;
+    MPI_Finalized(&finalized);
+    if (finalized) return 0;
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    return MPI_Request_free(req);
+  }
+
+  //! true if neighborhood collectives over a distributed graph are available (MPI-3)
+  static bool hasNeighborCollectives()
+  {
+#if MPI_VERSION >= 3
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  //! Absolute address of \a ptr, to be used as a displacement relative to MPI_BOTTOM
+  MPI_Aint getAddress(const void *ptr) const
+  {
+    MPI_Aint result;
+    MPI_Get_address(const_cast<void*>(ptr),&result);
+    return result;
+  }
+
+  /** \brief Create a distributed graph communicator where this process receives
+   * from processes with rank \a sources and sends to processes with rank
+   * \a destinations. Ranks are not reordered. This is a collective call.
+   */
+  int Dist_graph_create_adjacent(const std::vector<int> &sources,
+				 const std::vector<int> &destinations,
+				 MPI_Comm *graphCom) const
+  {
+#if MPI_VERSION >= 3
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Dist_graph_create_adjacent",0);
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    std::vector<int> src(sources);
+    std::vector<int> dst(destinations);
+    return MPI_Dist_graph_create_adjacent(com,
+					  src.size(),(src.size())?&src[0]:NULL,
+					  MPI_UNWEIGHTED,
+					  dst.size(),(dst.size())?&dst[0]:NULL,
+					  MPI_UNWEIGHTED,
+					  MPI_INFO_NULL,0,graphCom);
+#else
+    return -1;
+#endif
+  }
+
+  int Comm_free(MPI_Comm *graphCom) const
+  {
+    int finalized;
+    MPI_Finalized(&finalized);
+    if (finalized) return 0;
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    return MPI_Comm_free(graphCom);
+  }
+
+  // Send one element to each destination and receive one from each source of graphCom
+  template <typename T>
+  int Neighbor_alltoall(T *sendBuf, T *receiveBuf, MPI_Comm graphCom) const
+  {
+#if MPI_VERSION >= 3
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Neighbor_alltoall",0);
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    return MPI_Neighbor_alltoall(sendBuf,1,MPI_Type<T>::get(),
+				 receiveBuf,1,MPI_Type<T>::get(),graphCom);
+#else
+    return -1;
+#endif
+  }
+
+  // Displacements are absolute addresses (see getAddress()), so data is
+  // transfered in place from / to each buffer without packing.
+  int Neighbor_alltoallw(std::vector<int> &sendCounts,
+			 std::vector<MPI_Aint> &sendAddresses,
+			 std::vector<MPI_Datatype> &sendTypes,
+			 std::vector<int> &receiveCounts,
+			 std::vector<MPI_Aint> &receiveAddresses,
+			 std::vector<MPI_Datatype> &receiveTypes,
+			 MPI_Comm graphCom) const
+  {
+#if MPI_VERSION >= 3
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Neighbor_alltoallw",countBytes(sendCounts,sendTypes));
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    return MPI_Neighbor_alltoallw
+      (MPI_BOTTOM,
+       (sendCounts.size())?&sendCounts[0]:NULL,
+       (sendAddresses.size())?&sendAddresses[0]:NULL,
+       (sendTypes.size())?&sendTypes[0]:NULL,
+       MPI_BOTTOM,
+       (receiveCounts.size())?&receiveCounts[0]:NULL,
+       (receiveAddresses.size())?&receiveAddresses[0]:NULL,
+       (receiveTypes.size())?&receiveTypes[0]:NULL,
+       graphCom);
+#else
+    return -1;
+#endif
+  }
   /*
   template <class Container>
   int Irecv(Container &buffer, MPI_Datatype dataType, long node, MPI_Request *req, int tag=MPI_ANY_TAG)
@@ -591,7 +833,8 @@ public:
   int Wait(MPI_Request *req) const
   {
     MPI_Status status;
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Wait",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Wait(req, &status);
     
@@ -600,17 +843,32 @@ public:
 
   int Wait(MPI_Request *req, MPI_Status *status) const
   {   
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Wait",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Wait(req, status);
     
     return res;
   }
 
+  //! returns true if the request has completed (it is then released)
+  bool Test(MPI_Request *req) const
+  {
+    int flag=0;
+    MPI_Status status;
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Test",0);
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    MPI_Test(req, &flag, &status);
+
+    return (flag!=0);
+  }
+
   int Waitall(int count, MPI_Request *req) const
   {
     MPI_Status status[count];
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Waitall",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Waitall(count, req, status);
     
@@ -619,7 +877,8 @@ public:
 
   int Waitall(int count, MPI_Request *req, MPI_Status *status) const
   {   
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Waitall",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Waitall(count, req, status);
     
@@ -629,7 +888,8 @@ public:
   int Waitall(std::vector<MPI_Request> &req) const
   {
     MPI_Status status[req.size()];
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Waitall",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Waitall(req.size(), &req[0], status);
     
@@ -639,7 +899,8 @@ public:
   int Waitall(std::vector<MPI_Request> &req, std::vector<MPI_Status> &status) const
   {   
     status.resize(req.size());
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Waitall",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Waitall(req.size(), &req[0], &status[0]);
     
@@ -649,7 +910,8 @@ public:
   int Waitany(int count, MPI_Request *req, int *index, MPI_Status *status) const
   {   
     //int index;
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Waitany",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Waitany(count, req, index, status);
     
@@ -659,7 +921,8 @@ public:
   int Waitany(std::vector<MPI_Request> &req, int *index, MPI_Status *status) const
   {
     //int index;
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Waitany",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res=MPI_Waitany(req.size(), &req[0], index, status);
     
@@ -702,7 +965,8 @@ public:
   template <typename T>
   int Allgather_inplace(T* buffer, long count) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Allgather",count*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res= MPI_Allgather(MPI_IN_PLACE,0,MPI_DATATYPE_NULL,
 			 buffer,count,MPI_Type<T>::get(),com);	
@@ -713,7 +977,8 @@ public:
   template <class Container>
   int Allgather_inplace(Container &buffer) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Allgather",buffer.size()*sizeof(typename Container::value_type));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     int res= MPI_Allgather(MPI_IN_PLACE,0,MPI_DATATYPE_NULL,
 			 &buffer[0],buffer.size()/size(),
@@ -725,7 +990,8 @@ public:
   template <class Container>
   int Alltoall(Container &bufferIn, Container &bufferOut) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Alltoall",bufferIn.size()*sizeof(typename Container::value_type));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
     //if (omp_get_thread_num()==originThreadId) globalComTimer->start();
     int sz=bufferIn.size()/size();
@@ -739,7 +1005,8 @@ public:
   template <class T>
   int Alltoall(T *bufferIn, T *bufferOut, int sz) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Alltoall",static_cast<double>(sz)*nProcs*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     //if (omp_get_thread_num()==originThreadId) globalComTimer->start();
@@ -756,7 +1023,8 @@ public:
 		T *receiveBuf, int *receiveCount, int *receiveDisp, 
 		MPI_Datatype receiveType) const
   {    
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Alltoallv",countBytes(sendCount,sendType,nProcs));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     //if (omp_get_thread_num()==originThreadId) globalComTimer->start();
@@ -771,7 +1039,8 @@ public:
   int Alltoallv(T *sendBuf, int *sendCount, int *sendDisp,
 		T *receiveBuf, int *receiveCount, int *receiveDisp) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Alltoallv",countBytes(sendCount,MPI_Type<T>::get(),nProcs));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     //if (omp_get_thread_num()==originThreadId) globalComTimer->start();
@@ -788,7 +1057,8 @@ public:
 		T *receiveBuf,int *receiveCounts,int *receiveDisps,
 		MPI_Datatype *receiveTypes) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Alltoallw",countBytes(sendCounts,sendTypes,nProcs));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     //if (omp_get_thread_num()==originThreadId) globalComTimer->start();
@@ -801,7 +1071,8 @@ public:
   template <typename T>
   int Allreduce_inplace(T* buffer, long count, MPI_Op op) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Allreduce",count*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     int res= MPI_Allreduce(MPI_IN_PLACE,buffer,count,MPI_Type<T>::get(),op,com);
@@ -811,7 +1082,8 @@ public:
   template <class Container>
   int Allreduce_inplace(Container &buffer, MPI_Op op) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Allreduce",buffer.size()*sizeof(typename Container::value_type));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     int res= MPI_Allreduce(MPI_IN_PLACE,&buffer[0],buffer.size(),
@@ -823,7 +1095,8 @@ public:
   template <typename T>
   int Reduce_inplace(T* buffer, int root, long count, MPI_Op op) const
   {
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Reduce",count*sizeof(T));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     int res;
@@ -841,7 +1114,8 @@ public:
   template <class Container>
   int Reduce_inplace(Container &buffer, int root, MPI_Op op) const
   {    
-    MpiCallTimer timer(globalComTimer,originThreadId);
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Reduce",buffer.size()*sizeof(typename Container::value_type));
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     int res;
@@ -858,6 +1132,101 @@ public:
     
     return res;
   } 
+  /** \brief Register a value to be reduced over all processes at the next call to 
+   * startDeferredReductions(). All the registered values are combined in a single
+   * non blocking MPI_Iallreduce, whatever their type and reduction operation, and 
+   * \a value is only overwritten with the result by finishDeferredReductions(). This 
+   * is meant for statistics whose result is not needed right away, to avoid a global
+   * synchronization for each of them. Values are reduced as doubles, so integers are 
+   * exact up to 2^53. All the processes must register the same values in the same order.
+   * \param value a pointer to the value, that must remain valid until 
+   * finishDeferredReductions() returns.
+   * \param op the reduction operation: MPI_SUM, MPI_MIN or MPI_MAX
+   */
+  template <typename T>
+  void deferReduction(T *value, MPI_Op op)
+  {
+    DeferredReduction d;
+    d.ptr=value;
+    d.writeBack=&deferredWriteBack<T>;
+    deferredRegistered.push_back(d);
+    deferredRegisteredBuffer.push_back((op==MPI_MIN)?1:((op==MPI_MAX)?2:0));
+    deferredRegisteredBuffer.push_back(static_cast<double>(*value));
+  }
+
+  /** \brief Start reducing all the values registered with deferReduction() in a single
+   * non blocking collective call. If a previous batch is still being reduced, it is 
+   * completed first. This is a collective call.
+   */
+  void startDeferredReductions()
+  {
+    if (deferredInFlight.size()) completeDeferredReductions();
+    if (deferredRegistered.size()==0) return;
+
+    deferredInFlight.swap(deferredRegistered);
+    deferredInFlightBuffer.swap(deferredRegisteredBuffer);
+
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"deferredReductions",
+		       deferredInFlightBuffer.size()*sizeof(double));
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+
+    if (deferredOp==MPI_OP_NULL)
+      {
+	MPI_Op_create((MPI_User_function *) MPI_Deferred_impl, 1, &deferredOp);
+	MPI_Type_contiguous(2,MPI_DOUBLE,&deferredType);
+	MPI_Type_commit(&deferredType);
+      }
+#if MPI_VERSION >= 3
+    MPI_Iallreduce(MPI_IN_PLACE,&deferredInFlightBuffer[0],deferredInFlight.size(),
+		   deferredType,deferredOp,com,&deferredRequest);
+#else
+    MPI_Allreduce(MPI_IN_PLACE,&deferredInFlightBuffer[0],deferredInFlight.size(),
+		  deferredType,deferredOp,com);
+    deferredRequest=MPI_REQUEST_NULL;
+#endif
+  }
+
+  /** \brief Wait for the reductions started by startDeferredReductions() and write the
+   * results back to the registered values. Values registered but not started yet are 
+   * started first, so that all the registered values are up to date on return. This
+   * is a collective call if there are registered values.
+   * \return the number of values that were updated
+   */
+  long finishDeferredReductions()
+  {
+    long n=completeDeferredReductions();
+    if (deferredRegistered.size()) 
+      {
+	startDeferredReductions();
+	n+=completeDeferredReductions();
+      }
+    return n;
+  }
+
+private:
+  // wait for the reductions in flight and write back the results
+  long completeDeferredReductions()
+  {
+    if (deferredInFlight.size()==0) return 0;
+    
+    {
+      MpiCallTimer timer(globalComTimer,originThreadId,
+			 &callProfiler,"deferredReductionsWait",0);
+      MpiOmpLockChecker lockChecker(locker,threadSupport);
+      MPI_Wait(&deferredRequest,MPI_STATUS_IGNORE);
+    }
+
+    long n=deferredInFlight.size();
+    for (long i=0;i<n;++i)
+      deferredInFlight[i].writeBack(deferredInFlight[i].ptr,deferredInFlightBuffer[2*i+1]);
+    deferredInFlight.clear();
+    deferredInFlightBuffer.clear();
+    return n;
+  }
+
+public:
+
   /*
   bool Iprobe(int count)
   {
@@ -875,7 +1244,8 @@ public:
   int ProbeCount(int &count, int tag = MPI_ANY_TAG) const
   {    
     MPI_Status status;
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Probe",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Probe( MPI_ANY_SOURCE, tag, com, &status ); 
@@ -887,7 +1257,8 @@ public:
   int ProbeCount(int &count, MPI_Datatype &dataType, int tag = MPI_ANY_TAG) const
   {    
     MPI_Status status;
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Probe",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Probe( MPI_ANY_SOURCE, tag, com, &status ); 
@@ -896,10 +1267,27 @@ public:
     return status.MPI_SOURCE;
   }  
 
+  //! non blocking version of ProbeCount, returns -1 if no message is pending
+  int IprobeCount(int &count, MPI_Datatype &dataType, int tag = MPI_ANY_TAG) const
+  {    
+    int flag=0;
+    MPI_Status status;
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Iprobe",0);
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+
+    MPI_Iprobe( MPI_ANY_SOURCE, tag, com, &flag, &status ); 
+    if (!flag) return -1;
+    MPI_Get_count( &status, dataType, &count );
+    
+    return status.MPI_SOURCE;
+  }  
+
   int Probe(int tag = MPI_ANY_TAG) const
   {    
     MPI_Status status;
-    MpiCallTimer timer(localComTimer,originThreadId);
+    MpiCallTimer timer(localComTimer,originThreadId,
+		       &callProfiler,"Probe",0);
     MpiOmpLockChecker lockChecker(locker,threadSupport);
 
     MPI_Probe( MPI_ANY_SOURCE, tag, com, &status );
@@ -942,6 +1330,194 @@ public:
     return MPI_Abort(com,errorCode);
   } 
 
+  /** \brief Create the node local communicator grouping the processes that can 
+   * share memory. This is a collective call, but it only does something the 
+   * first time it is called.
+   * \return true if shared memory windows are supported (MPI-3)
+   */
+  bool initNodeCom()
+  {
+#if MPI_VERSION >= 3
+    if (nodeCom!=MPI_COMM_NULL) return true;
+
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"Comm_split_type",0);
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    
+    MPI_Comm_split_type(com,MPI_COMM_TYPE_SHARED,myRank,MPI_INFO_NULL,&nodeCom);
+    MPI_Comm_rank(nodeCom, &myNodeRank);
+    MPI_Comm_size(nodeCom, &myNodeSize);
+
+    // The leader is the process with node rank 0, and it has the lowest rank
+    int leader=myRank;
+    MPI_Bcast(&leader,1,MPI_INT,0,nodeCom);
+    nodeLeader.resize(nProcs);
+    MPI_Allgather(&leader,1,MPI_INT,&nodeLeader[0],1,MPI_INT,com);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /** \brief Start a thread that drives the progress of the pending non blocking
+   * communications in the background (see internal::MpiProgressThread), so that 
+   * transfers posted with Isend/Irecv overlap with local work even when the MPI 
+   * library has no asynchronous progress of its own. This is a collective call.
+   * \param period the polling period of the thread in microseconds
+   * \return false if the thread could not be started (MPI must support 
+   * MPI_THREAD_MULTIPLE and pthreads must be enabled)
+   */
+  bool startProgressThread(long period)
+  {
+    int ok=(threadSupport==MPI_THREAD_MULTIPLE);
+#ifndef USE_PTHREADS
+    ok=0;
+#endif
+    // all processes must agree as starting the thread is collective
+    MPI_Allreduce(MPI_IN_PLACE,&ok,1,MPI_INT,MPI_MIN,com);
+    if (!ok) return false;
+    return progressThread.start(com,period);
+  }
+
+  //! stop the progress thread started with startProgressThread()
+  void stopProgressThread()
+  {
+    progressThread.stop();
+  }
+
+  bool hasProgressThread() const
+  {
+    return progressThread.isRunning();
+  }
+
+  /** \brief Let MPI progress the pending non blocking communications. Long local
+   * computations that overlap with communications may call this from time to 
+   * time when no progress thread is running. This does nothing otherwise.
+   */
+  void progress() const
+  {
+    if (progressThread.isRunning()) return;
+    int flag;
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    MPI_Iprobe(MPI_ANY_SOURCE,MPI_ANY_TAG,com,&flag,MPI_STATUS_IGNORE);
+  }
+
+  /** \brief Renumber the processes to better match the hardware topology. This is a 
+   * collective call that replaces the communicator, so it must be called at startup,
+   * before anything depends on the ranks.
+   * \param mode REORDER_NODE gives contiguous ranks to the processes sharing a node 
+   * (i.e. a hierarchical node split), so that partitions that are contiguous in rank order, 
+   * such as consecutive Peano-Hilbert domains or FFT slabs, mostly communicate within a 
+   * node. REORDER_GRAPH lets the MPI library map a chain of processes (i.e. rank i 
+   * communicates with ranks i-1 and i+1) onto the physical topology through 
+   * MPI_Dist_graph_create_adjacent with reordering enabled.
+   * \return true if the rank of at least one process changed
+   */
+  bool reorderRanks(RankReordering mode)
+  {
+    if ((mode==REORDER_NONE)||(nProcs<2)) return false;
+#if MPI_VERSION >= 3
+    MpiCallTimer timer(globalComTimer,originThreadId,
+		       &callProfiler,"reorderRanks",0);
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+
+    MPI_Comm newCom;
+    if (mode==REORDER_NODE)
+      {
+	// processes of a node are sorted by the lowest rank on the node, and by 
+	// their current rank within the node
+	MPI_Comm tmpNodeCom;
+	int leader=myRank;
+	MPI_Comm_split_type(com,MPI_COMM_TYPE_SHARED,myRank,MPI_INFO_NULL,&tmpNodeCom);
+	MPI_Bcast(&leader,1,MPI_INT,0,tmpNodeCom);
+	MPI_Comm_free(&tmpNodeCom);
+	MPI_Comm_split(com,0,leader,&newCom);
+      }
+    else
+      {
+	std::vector<int> neighbors;
+	if (myRank>0) neighbors.push_back(myRank-1);
+	if (myRank<nProcs-1) neighbors.push_back(myRank+1);
+	MPI_Dist_graph_create_adjacent(com,
+				       neighbors.size(),&neighbors[0],MPI_UNWEIGHTED,
+				       neighbors.size(),&neighbors[0],MPI_UNWEIGHTED,
+				       MPI_INFO_NULL,1,&newCom);
+      }
+
+    int newRank;
+    MPI_Comm_rank(newCom,&newRank);
+    int changed=(newRank!=myRank);
+    MPI_Allreduce(MPI_IN_PLACE,&changed,1,MPI_INT,MPI_MAX,com);
+    if (!changed)
+      {
+	MPI_Comm_free(&newCom);
+	return false;
+      }
+
+    if (nodeCom!=MPI_COMM_NULL) MPI_Comm_free(&nodeCom);
+    if (deleteCom) MPI_Comm_free(&com);
+    deleteCom=true;
+    initCom(newCom);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  //! rank within the node local communicator (see initNodeCom())
+  int nodeRank() const {return myNodeRank;}
+  //! number of processes in the node local communicator (see initNodeCom())
+  int nodeSize() const {return myNodeSize;}
+  //! rank of the leader of process rk's node (see initNodeCom())
+  int getNodeLeader(int rk) const {return (nodeLeader.size())?nodeLeader[rk]:rk;}
+  bool isNodeLeader() const {return myNodeRank==0;}
+  bool sameNode(int rk) const {return getNodeLeader(rk)==getNodeLeader(myRank);}
+
+  /** \brief Allocate a buffer of \a nBytes shared by all the processes of the node.
+   * The memory is allocated by the node leader, and the window is kept in a 
+   * passive target access epoch until freeNodeShared() is called, so 
+   * syncNodeShared() must be used to synchronize accesses. This is collective over
+   * the node local communicator, and initNodeCom() must have been called first.
+   * \return a pointer to the shared buffer (same content for all node processes)
+   */
+  void *allocateNodeShared(size_t nBytes, MPI_Win *win) const
+  {
+    void *ptr=NULL;
+#if MPI_VERSION >= 3
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    MPI_Aint sz=(myNodeRank==0)?nBytes:0;
+    MPI_Aint qSize;
+    int dispUnit;
+    MPI_Win_allocate_shared(sz,1,MPI_INFO_NULL,nodeCom,&ptr,win);
+    MPI_Win_shared_query(*win,0,&qSize,&dispUnit,&ptr);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK,*win);
+#endif
+    return ptr;
+  }
+
+  //! Synchronize the node processes and make their updates to the shared buffer visible
+  void syncNodeShared(MPI_Win win) const
+  {
+#if MPI_VERSION >= 3
+    MpiCallTimer timer(barrierTimer,originThreadId,
+		       &callProfiler,"syncNodeShared",0);
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    MPI_Win_sync(win);
+    MPI_Barrier(nodeCom);
+    MPI_Win_sync(win);
+#endif
+  }
+
+  //! Free a buffer allocated with allocateNodeShared() (collective over the node)
+  void freeNodeShared(MPI_Win *win) const
+  {
+#if MPI_VERSION >= 3
+    MpiOmpLockChecker lockChecker(locker,threadSupport);
+    MPI_Win_unlock_all(*win);
+    MPI_Win_free(win);
+#endif
+  }
+
 #else // we do not have MPI
 private:
   //time_t refTime;
@@ -990,6 +1566,11 @@ public:
     return 0;
   }
 
+  bool Test(MPI_Request *req) const
+  {
+    return true;
+  }
+
   int Waitall(int count, MPI_Request *req) const
   {
     return 0;
@@ -1207,12 +1788,80 @@ public:
     return 0;
   }
 
+  template <typename T>
+  int Recv_init(T* rcv, long count, long node, MPI_Request *req, 
+		int tag=MPI_ANY_TAG) const
+  {
+    return 0;
+  }
+
+  template <typename T>
+  int Send_init(T* snd, long count, long node, MPI_Request *req, int tag=0) const
+  {
+    return 0;
+  }
+
+  int Startall(std::vector<MPI_Request> &req) const
+  {
+    return 0;
+  }
+
+  int Request_free(MPI_Request *req) const
+  {
+    return 0;
+  }
+
+  static bool hasNeighborCollectives()
+  {
+    return false;
+  }
+
+  MPI_Aint getAddress(const void *ptr) const
+  {
+    return 0;
+  }
+
+  int Dist_graph_create_adjacent(const std::vector<int> &sources,
+				 const std::vector<int> &destinations,
+				 MPI_Comm *graphCom) const
+  {
+    return 0;
+  }
+
+  int Comm_free(MPI_Comm *graphCom) const
+  {
+    return 0;
+  }
+
+  template <typename T>
+  int Neighbor_alltoall(T *sendBuf, T *receiveBuf, MPI_Comm graphCom) const
+  {
+    return 0;
+  }
+
+  int Neighbor_alltoallw(std::vector<int> &sendCounts,
+			 std::vector<MPI_Aint> &sendAddresses,
+			 std::vector<MPI_Datatype> &sendTypes,
+			 std::vector<int> &receiveCounts,
+			 std::vector<MPI_Aint> &receiveAddresses,
+			 std::vector<MPI_Datatype> &receiveTypes,
+			 MPI_Comm graphCom) const
+  {
+    return 0;
+  }
+
   template <typename T>
   int Reduce_inplace(T* buffer, int root, long count, MPI_Op op) const
   {
     return 0;
   }
 
+  // With a single process, deferred reductions leave the values unchanged
+  template <typename T>
+  void deferReduction(T *value, MPI_Op op) {}
+  void startDeferredReductions() {}
+  long finishDeferredReductions() {return 0;}
+
   template <class Container>
   int Reduce_inplace(Container &buffer, int root, MPI_Op op) const
   {    
@@ -1232,6 +1881,12 @@ public:
     return 0;
   }  
 
+  int IprobeCount(int &count, MPI_Datatype &dataType, int tag = MPI_ANY_TAG) const
+  {    
+    count=0;
+    return -1;
+  }  
+
   int Probe(int tag = MPI_ANY_TAG) const
   {    
     return 0;
@@ -1261,9 +1916,41 @@ public:
     exit(errorCode);
     return errorCode;
   } 
+
+  bool reorderRanks(RankReordering mode) {return false;}
+  bool startProgressThread(long period) {return false;}
+  void stopProgressThread() {}
+  bool hasProgressThread() const {return false;}
+  void progress() const {}
+  bool initNodeCom() {return false;}
+  int nodeRank() const {return 0;}
+  int nodeSize() const {return 1;}
+  int getNodeLeader(int rk) const {return rk;}
+  bool isNodeLeader() const {return true;}
+  bool sameNode(int rk) const {return rk==myRank;}
+
+  void *allocateNodeShared(size_t nBytes, MPI_Win *win) const {return NULL;}
+
+  void syncNodeShared(MPI_Win win) const {}
+  void freeNodeShared(MPI_Win *win) const {}
   //};
 
 #endif // HAVE_MPI
+
+  //! The profiler recording every MPI call (disabled by default, see enableCallProfiler())
+  internal::MpiCallProfiler *getCallProfiler() const {return &callProfiler;}
+
+  void enableCallProfiler(bool enable=true) {callProfiler.enable(enable);}
+
+  /** \brief Set the phase to which subsequent MPI calls are attributed by the call
+   *  profiler.
+   *  \return the previous phase, so that it can be restored.
+   */
+  std::string setCallProfilerPhase(const std::string &phase) const 
+  {
+    return callProfiler.setPhase(phase);
+  }
+
 /*
   static double Wtime()
   {
@@ -1343,6 +2030,29 @@ public:
 
 private:
   
+#ifdef USE_MPI
+  template <typename T>
+  static void deferredWriteBack(void *ptr, double value)
+  {
+    *static_cast<T*>(ptr)=static_cast<T>(value);
+  }
+
+  // Combine pairs (operation code, value), see deferReduction()
+  static void MPI_Deferred_impl(double *invec, double *inoutvec, int *len, 
+				MPI_Datatype *datatype)
+  {
+    for (int i=0;i<2*(*len);i+=2)
+      {
+	const int code=static_cast<int>(invec[i]);
+	if (code==0) inoutvec[i+1]+=invec[i+1];
+	else if (code==1) 
+	  {if (invec[i+1]<inoutvec[i+1]) inoutvec[i+1]=invec[i+1];}
+	else 
+	  {if (invec[i+1]>inoutvec[i+1]) inoutvec[i+1]=invec[i+1];}
+      }
+  }
+#endif
+
   template <typename T>
   static void MPI_Min_Max_Sum_impl(T *invec, T *inoutvec, int *len, MPI_Datatype *datatype)
   {
@@ -68,6 +68,7 @@ typedef int MPI_Datatype;
 typedef int MPI_Request;
 typedef void* MPI_Op;
 typedef int MPI_Aint;
+typedef int MPI_Win;
 struct MPI_Status {static const int MPI_SOURCE=0;};
 
 MPI_Op MPI_MAX = 0;
@@ -0,0 +1,277 @@
+#ifndef __MEMORY_POOL_ITERATOR_DYNAMIC_CHUNKS_HXX__
+#define __MEMORY_POOL_ITERATOR_DYNAMIC_CHUNKS_HXX__
+
+#include <iterator>
+#include <algorithm>
+#include "memoryPoolIterators.hxx"
+
+#include "../../../internal/namespace.header"
+
+// The iterable elements are cut into fixed size contiguous chunks. When the container
+// was prepared for a threaded iteration with the same stride (see
+// IterableMemoryPoolT::prepareThreadIteration), each of the 'stride' iterators claims
+// the next available chunk from a shared counter each time it exhausts its current one,
+// so that threads that were given cheap elements do not idle while others are still busy.
+// Otherwise, iterator 'delta' is statically given chunks delta, delta+stride, ... which
+// is still better balanced than contiguous blocks as the sorted (fast) and unsorted (slow)
+// regions of the pool are shared among all threads.
+// Note that in the dynamic case, every one of the 'stride' iterators MUST be iterated until
+// its end for the shared counter to be released (i.e. do not break out of the loop).
+
+namespace internal {
+
+  struct DynamicChunksState
+  {
+    DynamicChunksState():
+      stride(0),nElements(0),nChunks(0),chunkSize(0),nextChunk(0),nDone(0)
+    {}
+
+    static long defaultChunkSize(long nElements, long stride)
+    {
+      // about 16 chunks per thread, but not too small so that claiming is cheap
+      return std::max(nElements/(16*std::max(stride,1L)),64L);
+    }
+
+    void prepare(long nElements_, int stride_, long chunkSize_=0)
+    {
+      nElements = nElements_;
+      chunkSize = (chunkSize_>0)?chunkSize_:defaultChunkSize(nElements,stride_);
+      nChunks = (nElements+chunkSize-1)/chunkSize;
+      nextChunk=0;
+      nDone=0;
+      stride=(stride_>1)?stride_:0;
+    }
+
+    int stride; // 0 when not prepared
+    long nElements;
+    long nChunks;
+    long chunkSize;
+    long nextChunk;
+    int nDone;
+  };
+
+  template <class C, class V>
+  class MemoryPoolIteratorT<C,V,iteratorThreadModel::DynamicChunks>
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef iteratorThreadModel::DynamicChunks ThreadTraits;
+    typedef MemoryPoolIteratorT<C,V,ThreadTraits> self_type;
+
+    typedef C container_type;
+    typedef typename container_type::Type Type;
+    typedef V value_type;
+    typedef value_type* pointer;
+    typedef value_type& reference;
+    typedef const value_type* const_pointer;
+    typedef const value_type& const_reference;
+    typedef long difference_type;
+
+    MemoryPoolIteratorT(C *c,bool checkFreed_, bool end=false):
+      container(c),checkFreed(checkFreed_),state(NULL)
+    {
+      // A single chunk spanning the whole pool
+      nElements = container->getIterableElementsCount();
+      chunkSize = nElements;
+      nChunks = 1;
+      curChunk = 0;
+      stride = 1;
+
+      if ((end)||(container->getUsedCount()<1))
+	curPtr=NULL;
+      else
+	{
+	  initPages();
+	  setRange(0,nElements);
+	  skipInvalid();
+	}
+    }
+
+    MemoryPoolIteratorT(C *c,long delta, long stride_,bool checkFreed_, bool end=false):
+      container(c),checkFreed(checkFreed_),state(NULL)
+    {
+      nElements = container->getIterableElementsCount();
+      stride = stride_;
+
+      if (end)
+	{
+	  // end iterators must not claim any chunk !
+	  curPtr=NULL;
+	  return;
+	}
+
+      DynamicChunksState *st = container->getThreadIterationState();
+      // the pool may have changed since it was prepared, in which case we fall back
+      // to the static distribution
+      if ((st->stride>1)&&(st->stride==stride)&&(st->nElements==nElements))
+	{
+	  state = st;
+	  chunkSize = state->chunkSize;
+	  nChunks = state->nChunks;
+	}
+      else
+	{
+	  chunkSize = DynamicChunksState::defaultChunkSize(nElements,stride);
+	  nChunks = (nElements+chunkSize-1)/chunkSize;
+	  curChunk = delta-stride;
+	}
+
+      initPages();
+      if (claimChunk()) skipInvalid();
+    }
+
+    virtual ~MemoryPoolIteratorT()
+    {
+
+    }
+
+    value_type operator->() const
+    {
+      return static_cast<value_type>(curPtr);
+    }
+
+    value_type operator*() const
+    {
+      return static_cast<value_type>(curPtr);
+    }
+
+    inline self_type &operator++()
+    {
+      ++curPtr;
+      skipInvalid();
+      return *this;
+    }
+
+    const self_type operator++(int)
+    {
+      self_type it(*this);
+      ++(*this);
+      return it;
+    }
+
+    bool operator==(const self_type& r) const
+    {return (curPtr==r.curPtr);}
+
+    bool operator!=(const self_type& r) const
+    {return (curPtr!=r.curPtr);}
+
+  private:
+    void initPages()
+    {
+      storageBegin = container->getStorage().begin();
+      pageIndex = 0;
+      pageStart = 0;
+    }
+
+    // Sets curPtr/endPtr to the first page of range [start,stop[. Ranges are always
+    // requested in increasing order so we only need to look forward for the page.
+    void setRange(long start, long stop)
+    {
+      while (start >= pageStart + container->getStorageSize(pageIndex))
+	{
+	  pageStart += container->getStorageSize(pageIndex);
+	  pageIndex++;
+	}
+      rangeStop = stop;
+      stIt = storageBegin + pageIndex;
+      curPtr = container->getStorageBegin(stIt) + (start-pageStart);
+      setEndPtr();
+    }
+
+    void setEndPtr()
+    {
+      long pageStop = pageStart + container->getStorageSize(pageIndex);
+      endPtr = container->getStorageBegin(stIt) +
+	(std::min(pageStop,rangeStop)-pageStart);
+    }
+
+    bool nextPage()
+    {
+      long pageStop = pageStart + container->getStorageSize(pageIndex);
+      if (pageStop >= rangeStop) return false;
+
+      pageStart = pageStop;
+      pageIndex++;
+      ++stIt;
+      curPtr = container->getStorageBegin(stIt);
+      setEndPtr();
+      return true;
+    }
+
+    bool claimChunk()
+    {
+      if (state!=NULL)
+	{
+#pragma omp atomic capture
+	  {
+	    // fetch_and_add
+	    curChunk=state->nextChunk;
+	    state->nextChunk = state->nextChunk+1;
+	  }
+
+	  if (curChunk >= nChunks)
+	    {
+	      // The last iterator to run out of chunks releases the shared counter
+	      int nDone;
+#pragma omp atomic capture
+	      {
+		nDone=state->nDone;
+		state->nDone = state->nDone+1;
+	      }
+	      if (nDone+1 == stride) state->stride=0;
+	      state=NULL;
+	    }
+	}
+      else curChunk += stride;
+
+      if (curChunk >= nChunks)
+	{
+	  curPtr=NULL;
+	  return false;
+	}
+
+      long start = curChunk*chunkSize;
+      setRange(start,std::min(start+chunkSize,nElements));
+      return true;
+    }
+
+    // Moves forward from curPtr (included) to the next valid element, or NULL
+    void skipInvalid()
+    {
+      while (true)
+	{
+	  if (curPtr==endPtr)
+	    {
+	      if ((!nextPage())&&(!claimChunk())) return;
+	    }
+	  else if ((checkFreed)&&(curPtr->isFree()))
+	    ++curPtr;
+	  else return;
+	}
+    }
+
+  protected:
+    typedef typename C::StorageIterator StorageIterator;
+    typedef typename C::BaseValueType BaseValueType;
+
+    container_type *container;
+    BaseValueType curPtr;
+    BaseValueType endPtr;
+    long checkFreed;
+    DynamicChunksState *state;
+    StorageIterator storageBegin;
+    StorageIterator stIt;
+    long pageIndex;
+    long pageStart;
+    long rangeStop;
+    long nElements;
+    long chunkSize;
+    long nChunks;
+    long curChunk;
+    long stride;
+  };
+
+} // internal
+
+#include "../../../internal/namespace.footer"
+#endif
@@ -16,5 +16,6 @@ namespace internal {
 #include "memoryPoolIteratorAlternate.hxx"
 #include "memoryPoolIteratorBlocks.hxx"
 #include "memoryPoolIteratorSortedBlocks.hxx"
+#include "memoryPoolIteratorDynamicChunks.hxx"
 
 #endif
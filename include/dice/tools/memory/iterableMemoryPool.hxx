@@ -15,6 +15,7 @@
 #include "./internal/memoryPoolValueIterator.hxx"
 
 #include "../sort/ompPSort.hxx"
+#include "../sort/ompRadixSort.hxx"
 
 /**
  * @file 
@@ -289,6 +290,19 @@ public:
     return const_value_iterator(this,delta,stride,(Base::getRecycledCount()>0),true);
   }
 
+  /** \brief Prepares the next threaded iteration over the pool, where each of the 
+   *  \a stride iterators obtained from begin(delta,stride) claim chunks of \a chunkSize 
+   *  elements dynamically from a shared counter. This is only used by the 
+   *  iteratorThreadModel::DynamicChunks policy, and must be called before entering the 
+   *  parallel region. Each of the \a stride iterators must then be iterated to its end.
+   *  \param stride the number of iterators that will share the pool elements
+   *  \param chunkSize number of elements per chunk (a default value is used if <=0)
+   */
+  void prepareThreadIteration(int stride, long chunkSize=0)
+  {
+    threadIterationState.prepare(getIterableElementsCount(),stride,chunkSize);
+  }
+
   double getIteratorWastedRatio()
   {
     if (Base::getAllocatedCount()==0) return 0;
@@ -410,7 +424,9 @@ public:
     for (long i=0;i<nElements;++i)
       newIndex[i]=i;
 
-    // Sort elements indices in ascending order of their corresponding values   
+    // Sort elements indices in ascending order of their corresponding values.
+    // Integer keys (e.g. Peano-Hilbert codes) are radix sorted in linear time,
+    // other types fall back to a comparison based parallel sort (ompPSort).
     
     // This Lambda function declaration makes Clang++ 3.4 crash due to a bug.     
     //ompPSort(newIndex.begin(),newIndex.end(),nThreads,
@@ -418,14 +434,8 @@ public:
     //	     {return value[a]<value[b];}
     //	     );
 
-    struct CmpValue
-    {
-      const std::vector<Value> &value;
-      CmpValue(const std::vector<Value> &value_):value(value_){}
-      bool operator()(long a, long b) const
-      {return value[a]<value[b];}
-    } cmpValue(value);
-    ompPSort(newIndex.begin(),newIndex.end(),nThreads,cmpValue);
+    if (nElements>0)
+      ompSortByKey(&value[0],&newIndex[0],nElements,nThreads);
     
     // Single threaded version
     // std::sort(newIndex.begin(),newIndex.end(),[&value](long a, long b)
@@ -500,6 +510,7 @@ protected:
   typedef typename Base::value_type BaseValueType;
 
   long nSortedElements;
+  mutable internal::DynamicChunksState threadIterationState;
 
   void newChunk(size_t forcedSize=0)
   {
@@ -541,6 +552,11 @@ protected:
     return Base::storage;
   }
 
+  internal::DynamicChunksState *getThreadIterationState() const
+  {
+    return &threadIterationState;
+  }
+
   long getStorageSize(long i)
   {
     return Base::allocatedSize[i];
@@ -21,6 +21,7 @@ namespace iteratorThreadModel {
   class Blocks{}; /*!< each thread is given a contiguous block of elements */
   class Alternate{}; /*!< each thread is given one element every num_threads elements */
   class SortedBlocks{}; /*!< each thread is given two blocks (each of them contiguous): one in the sorted region, one in the unsorted region  */
+  class DynamicChunks{}; /*!< the pool is cut into fixed size contiguous chunks that threads claim dynamically (see IterableMemoryPoolT::prepareThreadIteration), or one every num_threads chunks otherwise */
 }
 
 /** \}*/
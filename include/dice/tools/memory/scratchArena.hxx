@@ -0,0 +1,302 @@
+#ifndef __SCRATCH_ARENA_HXX__
+#define __SCRATCH_ARENA_HXX__
+
+#include <stdlib.h>
+
+#include <vector>
+#include <limits>
+#include <new>
+#include <algorithm>
+
+#include "../../dice_globals.hxx"
+#include "../OMP/openMP_interface.hxx"
+
+/**
+ * @file
+ * @brief Defines per-thread bump allocators (arenas) for short lived temporaries, and an
+ * STL allocator that uses them.
+ * @author Thierry Sousbie
+ */
+
+#include "../../internal/namespace.header"
+
+/** \addtogroup TOOLS
+ *   \{
+ */
+
+/**
+ * \class ScratchArena
+ * \brief A simple bump allocator. Memory is only given back when reset() is called,
+ * except for the last allocated block which can be rewound. After reset, the arena is
+ * consolidated into a single block large enough to hold everything that was allocated
+ * since the previous reset, so that after a few calls the arena does not need to
+ * allocate (and page fault) anymore. A ScratchArena is NOT thread safe.
+ */
+class ScratchArena
+{
+public:
+  static const size_t ALIGNMENT = 64;
+
+  ScratchArena(size_t minBlockSize_=(1<<20)):
+    minBlockSize(minBlockSize_),
+    curBlock(0),
+    offset(0),
+    used(0),
+    peak(0)
+  {}
+
+  ~ScratchArena()
+  {
+    release();
+  }
+
+  void *allocate(size_t nBytes)
+  {
+    nBytes = align(nBytes);
+
+    while (curBlock<blocks.size())
+      {
+	if (offset+nBytes <= blocks[curBlock].size)
+	  break;
+	// remaining space in the current block is lost until next reset
+	used += blocks[curBlock].size-offset;
+	curBlock++;
+	offset=0;
+      }
+
+    if (curBlock==blocks.size())
+      {
+	size_t sz=std::max(nBytes,minBlockSize);
+	if (!blocks.empty()) sz=std::max(sz,blocks.back().size);
+	newBlock(sz);
+      }
+
+    void *result = blocks[curBlock].data+offset;
+    offset+=nBytes;
+    used+=nBytes;
+    if (used>peak) peak=used;
+    return result;
+  }
+
+  // Only the last allocation is actually freed, others are reclaimed by reset()
+  bool deallocate(void *ptr, size_t nBytes)
+  {
+    nBytes = align(nBytes);
+    if (curBlock>=blocks.size()) return false;
+    if (static_cast<char*>(ptr)+nBytes != blocks[curBlock].data+offset) return false;
+    offset-=nBytes;
+    used-=nBytes;
+    return true;
+  }
+
+  // Frees everything that was allocated, everything allocated from the arena must
+  // have been destroyed !
+  void reset()
+  {
+    if (blocks.size()>1)
+      {
+	size_t sz=getCapacity();
+	release();
+	newBlock(sz);
+      }
+    curBlock=0;
+    offset=0;
+    used=0;
+  }
+
+  // Really frees the memory
+  void release()
+  {
+    for (unsigned long i=0;i<blocks.size();++i)
+      free(blocks[i].data);
+    blocks.clear();
+    curBlock=0;
+    offset=0;
+    used=0;
+  }
+
+  size_t getUsed() const {return used;}
+  size_t getPeak() const {return peak;}
+  size_t getCapacity() const
+  {
+    size_t result=0;
+    for (unsigned long i=0;i<blocks.size();++i)
+      result+=blocks[i].size;
+    return result;
+  }
+
+private:
+  struct Block
+  {
+    char *data;
+    size_t size;
+  };
+
+  static size_t align(size_t nBytes)
+  {
+    return ((nBytes+ALIGNMENT-1)/ALIGNMENT)*ALIGNMENT;
+  }
+
+  void newBlock(size_t sz)
+  {
+    Block b;
+    if (posix_memalign((void**)&b.data,ALIGNMENT,sz))
+      throw std::bad_alloc();
+    b.size=sz;
+    blocks.push_back(b);
+  }
+
+  std::vector<Block> blocks;
+  size_t minBlockSize;
+  size_t curBlock;
+  size_t offset;
+  size_t used;
+  size_t peak;
+};
+
+/**
+ * \class ScratchArenas
+ * \brief One ScratchArena per openMP thread. The arenas are reset all at once by calling
+ * reset(), which must be done outside of any parallel region when no temporary allocated
+ * from them is alive anymore (e.g. at the end of each time step of the solver).
+ */
+class ScratchArenas
+{
+public:
+  ScratchArenas(int nThreads)
+  {
+    arenas.resize(std::max(nThreads,1));
+    for (unsigned long i=0;i<arenas.size();++i)
+      arenas[i]=new ScratchArena();
+  }
+
+  ~ScratchArenas()
+  {
+    for (unsigned long i=0;i<arenas.size();++i)
+      delete arenas[i];
+  }
+
+  // Returns NULL if the calling thread has no arena
+  ScratchArena *getThreadArena()
+  {
+    unsigned long th = omp_get_thread_num();
+    if (th>=arenas.size()) return NULL;
+    return arenas[th];
+  }
+
+  void reset()
+  {
+    for (unsigned long i=0;i<arenas.size();++i)
+      arenas[i]->reset();
+  }
+
+  void release()
+  {
+    for (unsigned long i=0;i<arenas.size();++i)
+      arenas[i]->release();
+  }
+
+  template <class L>
+  void report()
+  {
+    size_t capacity=0;
+    size_t peak=0;
+    for (unsigned long i=0;i<arenas.size();++i)
+      {
+	capacity+=arenas[i]->getCapacity();
+	peak+=arenas[i]->getPeak();
+      }
+    glb::console->print<L>("Scratch arenas [capacity, peak]: [%lg, %lg] Mo.\n",
+			   double(capacity)/(1<<20),double(peak)/(1<<20));
+  }
+
+private:
+  std::vector<ScratchArena *> arenas;
+};
+
+/**
+ * \class ScratchAllocatorT
+ * \brief An STL allocator that allocates from the calling thread's arena in
+ * glb::scratchArenas (or from the heap if there is none). Memory obtained from the
+ * arenas is only reclaimed when glb::scratchArenas is reset, so containers using this
+ * allocator must not outlive the current time step.
+ * \tparam T the type of the allocated objects
+ */
+template <class T>
+class ScratchAllocatorT
+{
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template <class U> struct rebind {typedef ScratchAllocatorT<U> other;};
+
+  ScratchAllocatorT() {}
+  template <class U> ScratchAllocatorT(const ScratchAllocatorT<U> &) {}
+
+  pointer allocate(size_type n, const void * =0)
+  {
+    if (n>max_size()) throw std::bad_alloc();
+    const size_t nBytes = n*sizeof(T)+HEADER_SIZE;
+    ScratchArena *arena = (glb::scratchArenas==NULL)?NULL:
+      glb::scratchArenas->getThreadArena();
+
+    char *ptr;
+    if (arena!=NULL)
+      ptr = static_cast<char*>(arena->allocate(nBytes));
+    else
+      {
+	ptr = static_cast<char*>(malloc(nBytes));
+	if (ptr==NULL) throw std::bad_alloc();
+      }
+    // We store where the memory comes from so that it can be given back there
+    *reinterpret_cast<ScratchArena**>(ptr) = arena;
+    return reinterpret_cast<pointer>(ptr+HEADER_SIZE);
+  }
+
+  void deallocate(pointer p, size_type n)
+  {
+    if (p==NULL) return;
+    char *ptr = reinterpret_cast<char*>(p)-HEADER_SIZE;
+    ScratchArena *arena = *reinterpret_cast<ScratchArena**>(ptr);
+    if (arena==NULL)
+      free(ptr);
+    else if ((glb::scratchArenas!=NULL)&&(arena==glb::scratchArenas->getThreadArena()))
+      arena->deallocate(ptr,n*sizeof(T)+HEADER_SIZE);
+  }
+
+  size_type max_size() const
+  {
+    return (std::numeric_limits<size_type>::max()-HEADER_SIZE)/sizeof(T);
+  }
+
+  void construct(pointer p, const T& val) {new((void*)p) T(val);}
+  void destroy(pointer p) {p->~T();}
+
+  template <class U> bool operator==(const ScratchAllocatorT<U> &) const {return true;}
+  template <class U> bool operator!=(const ScratchAllocatorT<U> &) const {return false;}
+
+private:
+  // keeps the returned memory aligned for any fundamental type
+  static const size_t HEADER_SIZE = 16;
+};
+
+/**
+ * \struct ScratchVectorT
+ * \brief Defines a std::vector type that allocates from the scratch arenas, see
+ * ScratchAllocatorT
+ */
+template <class T>
+struct ScratchVectorT
+{
+  typedef std::vector<T, ScratchAllocatorT<T> > Type;
+};
+
+/** \}*/
+#include "../../internal/namespace.footer"
+#endif
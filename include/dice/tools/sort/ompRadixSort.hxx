@@ -0,0 +1,255 @@
+#ifndef __OPEN_MP_RADIX_SORT__
+#define __OPEN_MP_RADIX_SORT__
+
+#include <vector>
+#include <algorithm>
+
+#include "../../dice_globals.hxx"
+#include "../OMP/openMP_interface.hxx"
+#include "ompPSort.hxx"
+
+/**
+ * @file
+ * @brief A openMP parallel LSD radix sort of key / value pairs
+ * @author Thierry Sousbie
+ */
+
+#include "../../internal/namespace.header"
+/** \addtogroup TOOLS
+ *   \{
+ */
+
+/** \brief Defines how a key type is decomposed into bytes for radix sorting.
+ *  Keys are radix sortable if they are unsigned integers, or if they define a
+ *  RadixSortable type, a RADIX_BYTES static constant giving their size in bytes
+ *  and a member function radixByte(int b) returning their b-th least significant
+ *  byte such that the byte wise order matches operator< (e.g. PeanoHilbertT::HCode).
+ *  \a value is true if the type is radix sortable.
+ */
+template <class K>
+struct IsRadixSortable
+{
+private:
+  template <class U> static char test(typename U::RadixSortable*);
+  template <class U> static long test(...);
+public:
+  static const bool value = (sizeof(test<K>(0))==1);
+};
+
+template <class K, bool R=IsRadixSortable<K>::value>
+struct RadixSortTraits
+{
+  static const bool value = false;
+};
+
+template <class K>
+struct RadixSortTraits<K,true>
+{
+  static const bool value = true;
+  static const int nBytes = K::RADIX_BYTES;
+  static unsigned char byte(const K &key, int b) {return key.radixByte(b);}
+};
+
+#define DEFINE_UNSIGNED_RADIX_SORT_TRAITS(type)				\
+  template <>								\
+  struct RadixSortTraits<type,false>					\
+  {									\
+    static const bool value = true;					\
+    static const int nBytes = sizeof(type);				\
+    static unsigned char byte(const type &key, int b)			\
+    {return static_cast<unsigned char>(key>>(8*b));}			\
+  };
+
+DEFINE_UNSIGNED_RADIX_SORT_TRAITS(unsigned char)
+DEFINE_UNSIGNED_RADIX_SORT_TRAITS(unsigned short)
+DEFINE_UNSIGNED_RADIX_SORT_TRAITS(unsigned int)
+DEFINE_UNSIGNED_RADIX_SORT_TRAITS(unsigned long)
+DEFINE_UNSIGNED_RADIX_SORT_TRAITS(unsigned long long)
+
+#undef DEFINE_UNSIGNED_RADIX_SORT_TRAITS
+
+/** \brief Stable parallel sort of \a len keys in ascending order, the values being
+ *  reordered along with their keys. This is a least significant digit radix sort
+ *  with one pass per byte of the keys : each thread counts the occurrences of each
+ *  byte value in its own range of the array (per-thread histograms), which gives
+ *  every thread the exact positions where to scatter its elements. Bytes that are
+ *  the same for all the keys are detected beforehand and skipped, so the cost is
+ *  O(len) per significant byte instead of O(len.log(len)). Needs a temporary copy
+ *  of the keys and values.
+ *  \param keys the keys, K must be radix sortable (see RadixSortTraits)
+ *  \param values the values associated to each key
+ *  \param len the number of elements
+ *  \param nThreads the number of openMP threads to use
+ */
+template <class K, class V>
+void ompRadixSort(K *keys, V *values, long len, int nThreads=glb::num_omp_threads)
+{
+  typedef RadixSortTraits<K> Traits;
+  static const int nBytes=Traits::nBytes;
+  static const int nBuckets=256;
+
+  if (len<2) return;
+  if (nThreads<1) nThreads=1;
+  if (len<nThreads*nBuckets) nThreads=1;
+
+  // The array is split into nThreads ranges, each with its own histograms.
+  // First compute the histogram of each byte, which is used to skip the passes
+  // where all the keys share the same byte value
+  std::vector<long> threadCount(nThreads*nBytes*nBuckets,0);
+#pragma omp parallel for num_threads(nThreads)
+  for (int th=0;th<nThreads;++th)
+    {
+      const long i0=(len*th)/nThreads;
+      const long i1=(len*(th+1))/nThreads;
+      long *count=&threadCount[th*nBytes*nBuckets];
+      for (long i=i0;i<i1;++i)
+	for (int b=0;b<nBytes;++b)
+	  count[b*nBuckets+Traits::byte(keys[i],b)]++;
+    }
+
+  std::vector<int> passes;
+  for (int b=0;b<nBytes;++b)
+    {
+      bool trivial=false;
+      for (int d=0;(d<nBuckets)&&(!trivial);++d)
+	{
+	  long total=0;
+	  for (int t=0;t<nThreads;++t)
+	    total+=threadCount[(t*nBytes+b)*nBuckets+d];
+	  if (total==len) trivial=true;
+	  else if (total>0) break;
+	}
+      if (!trivial) passes.push_back(b);
+    }
+  if (passes.empty()) return;
+
+  std::vector<K> tmpKeys(len);
+  std::vector<V> tmpValues(len);
+  K *srcK=keys;
+  V *srcV=values;
+  K *dstK=&tmpKeys[0];
+  V *dstV=&tmpValues[0];
+  std::vector<long> offset(nThreads*nBuckets);
+
+  for (unsigned long p=0;p<passes.size();++p)
+    {
+      const int b=passes[p];
+
+      // the initial histograms are only valid for the original order
+      if (p==0)
+	{
+	  for (int th=0;th<nThreads;++th)
+	    std::copy(&threadCount[(th*nBytes+b)*nBuckets],
+		      &threadCount[(th*nBytes+b)*nBuckets]+nBuckets,
+		      &offset[th*nBuckets]);
+	}
+      else
+	{
+#pragma omp parallel for num_threads(nThreads)
+	  for (int th=0;th<nThreads;++th)
+	    {
+	      const long i0=(len*th)/nThreads;
+	      const long i1=(len*(th+1))/nThreads;
+	      long *myOffset=&offset[th*nBuckets];
+	      std::fill_n(myOffset,nBuckets,0);
+	      for (long i=i0;i<i1;++i)
+		myOffset[Traits::byte(srcK[i],b)]++;
+	    }
+	}
+
+      // elements with digit d from range t go after all the elements with a lower
+      // digit, and those with digit d from ranges t'<t
+      long cur=0;
+      for (int d=0;d<nBuckets;++d)
+	for (int th=0;th<nThreads;++th)
+	  {
+	    long n=offset[th*nBuckets+d];
+	    offset[th*nBuckets+d]=cur;
+	    cur+=n;
+	  }
+
+#pragma omp parallel for num_threads(nThreads)
+      for (int th=0;th<nThreads;++th)
+	{
+	  const long i0=(len*th)/nThreads;
+	  const long i1=(len*(th+1))/nThreads;
+	  long *myOffset=&offset[th*nBuckets];
+	  for (long i=i0;i<i1;++i)
+	    {
+	      long j=myOffset[Traits::byte(srcK[i],b)]++;
+	      dstK[j]=srcK[i];
+	      dstV[j]=srcV[i];
+	    }
+	}
+      std::swap(srcK,dstK);
+      std::swap(srcV,dstV);
+    }
+
+  if (srcK!=keys)
+    {
+#pragma omp parallel for num_threads(nThreads)
+      for (long i=0;i<len;++i)
+	{
+	  keys[i]=srcK[i];
+	  values[i]=srcV[i];
+	}
+    }
+}
+
+namespace internal {
+
+  template <class K>
+  struct OmpSortByKeyCmp
+  {
+    OmpSortByKeyCmp(const K *k):keys(k) {}
+    bool operator()(long a, long b) const {return keys[a]<keys[b];}
+    const K *keys;
+  };
+
+  template <class K, class V, bool radix=RadixSortTraits<K>::value>
+  struct OmpSortByKey
+  {
+    static void sort(K *keys, V *values, long len, int nThreads)
+    {
+      // sort a permutation of the elements and apply it
+      std::vector<long> index(len);
+#pragma omp parallel for num_threads(nThreads)
+      for (long i=0;i<len;++i) index[i]=i;
+      OmpSortByKeyCmp<K> cmp(keys);
+      MY_NAMESPACE:: ompPSort(index.begin(),index.end(),nThreads,cmp);
+
+      std::vector<K> tmpKeys(keys,keys+len);
+      std::vector<V> tmpValues(values,values+len);
+#pragma omp parallel for num_threads(nThreads)
+      for (long i=0;i<len;++i)
+	{
+	  keys[i]=tmpKeys[index[i]];
+	  values[i]=tmpValues[index[i]];
+	}
+    }
+  };
+
+  template <class K, class V>
+  struct OmpSortByKey<K,V,true>
+  {
+    static void sort(K *keys, V *values, long len, int nThreads)
+    {
+      ompRadixSort(keys,values,len,nThreads);
+    }
+  };
+
+}
+
+/** \brief Sort \a len keys in ascending order, the values being reordered along with
+ *  their keys. A parallel radix sort is used when K is radix sortable (see
+ *  RadixSortTraits), and a comparison based sort (see ompPSort) otherwise.
+ */
+template <class K, class V>
+void ompSortByKey(K *keys, V *values, long len, int nThreads=glb::num_omp_threads)
+{
+  internal::OmpSortByKey<K,V>::sort(keys,values,len,nThreads);
+}
+
+/** \}*/
+#include "../../internal/namespace.footer"
+#endif
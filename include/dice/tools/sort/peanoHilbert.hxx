@@ -1,6 +1,14 @@
 #ifndef __PEANO_HILBERT_HXX__
 #define __PEANO_HILBERT_HXX__
 
+#include <algorithm>
+#include <limits>
+
+#if defined(__BMI2__) && defined(__x86_64__)
+#include <immintrin.h>
+#define PEANO_HILBERT_USE_BMI2
+#endif
+
 /**
  * @file 
  * @brief  A Peano-Hilbert N-D coordinates to 1-D distance mapping class
@@ -16,7 +24,9 @@
  * \class PeanoHilbertT
  * \brief  A static class used to convert coordinates to distance over a peano hilbert curve
  * or reciprocally. It work in any number of dimensions and to any order ...
- * The core of the code is from J.K. Lawder, 2000.
+ * The core of the code is from J.K. Lawder, 2000, and is used to tabulate the 
+ * transitions of the curve so that keys are computed NDIM bits at a time. Use 
+ * coordsToLengths / lengthsToCoords to convert arrays of points.
  * \tparam ND The number of dimensions
  * \tparam maxOrder the maximum order of the PH curve: it may have a resolution of (1<<maxOrder) at most along each dimension.
  */
@@ -38,6 +48,17 @@ public:
     static const int NDIM = ND;
     Index hcode[NDIM];
 
+    // HCodes can be sorted with ompRadixSort (see RadixSortTraits)
+    typedef void RadixSortable;
+    static const int RADIX_BYTES = NDIM*sizeof(Index);
+
+    /** \brief returns the b-th least significant byte of the code
+     */
+    unsigned char radixByte(int b) const
+    {
+      return static_cast<unsigned char>(hcode[b/sizeof(Index)]>>(8*(b%sizeof(Index))));
+    }
+
     /** \brief Converts the HCode to a floating point distance (precision may be lost)
      *  \tparam FT the floating point type to convert to
      */
@@ -148,13 +169,265 @@ public:
 	coords[i]= x0[i] + (coords[i] * delta[i]);
       }
   }
+
+  /** \brief Convert an array of coordinates to distances along the PH curve. This is
+   *  faster than converting the points one by one, as the coordinates are first
+   *  rescaled by blocks in a vectorizable loop.
+   *  \param[in]  coords coordinates of the n points (NDIM consecutive values per point)
+   *  \param[in]  n      the number of points
+   *  \param[out] lengths distance along the curve of each point (n values)
+   *  \param      x0     Coordinates of the lower left corner of the bounding box
+   *  \param      delta_inv inverse of the size of the bounding box along each dimension
+   *  \param      order  order of the PH curve (see coordsToLength)
+   */
+  template <typename CT, typename DT>
+  static void coordsToLengths(const CT *coords, long n, HCode *lengths,
+			      const DT x0[NDIM], const DT delta_inv[NDIM],
+			      int order=maxOrder)
+  {
+    static const long BLOCK_SIZE=256;
+    const double scale=std::numeric_limits<Index>::max();
+    Index p[BLOCK_SIZE*NDIM];
+
+    for (long i0=0;i0<n;i0+=BLOCK_SIZE)
+      {
+	const long nb=std::min(BLOCK_SIZE,n-i0);
+	const CT *c=coords+i0*NDIM;
+	for (long i=0;i<nb;++i)
+	  for (int j=0;j<NDIM;++j)
+	    p[i*NDIM+j] = static_cast<Index>
+	      (((c[i*NDIM+j]-x0[j])*delta_inv[j]) * scale);
+
+	for (long i=0;i<nb;++i)
+	  lengths[i0+i] = H_encode(&p[i*NDIM],order);
+      }
+  }
+
+  /** \brief Convert an array of distances along the PH curve to coordinates.
+   *  \param[in]  lengths distance along the curve of the n points
+   *  \param[in]  n      the number of points
+   *  \param[out] coords coordinates of the n points (NDIM consecutive values per point)
+   *  \param      x0     Coordinates of the lower left corner of the bounding box
+   *  \param      delta  The size of the bounding box along each dimension
+   *  \param      order  order of the PH curve (see coordsToLength)
+   */
+  template <typename CT, typename DT>
+  static void lengthsToCoords(const HCode *lengths, long n, CT *coords,
+			      const DT x0[NDIM], const DT delta[NDIM],
+			      int order=maxOrder)
+  {
+    const double scale=std::numeric_limits<Index>::max();
+    for (long i=0;i<n;++i)
+      {
+	HCode point = H_decode(lengths[i],order);
+	for (int j=0;j<NDIM;++j)
+	  coords[i*NDIM+j]=x0[j] + 
+	    static_cast<CT>((static_cast<double>(point.hcode[j])/scale)*delta[j]);
+      }
+  }
   
 private: 
 typedef Index HCT;
 typedef HCode Point;
+typedef hlp::ULongInt64 Chunk;
+
   static HCT g_mask(int i) {return HCT(1)<<(NDIM-1-i);}
 
-  // From here, this is an adapted version of J.K. Lawder, 2000
+  /*
+    The curve is computed one level (i.e. one bit of each coordinate, NDIM bits 
+    of the key) at a time by a state machine whose transitions are tabulated: 
+    the state only depends on the accumulated transform W and on the rotation xJ 
+    (modulo NDIM) of Lawder's algorithm below, so there are NDIM.2^NDIM states.
+    The NDIM bits of a level are gathered from the coordinates (or scattered 
+    back) by chunks of up to 64 bits, using the BMI2 pdep / pext instructions when 
+    they are available.
+   */
+  static const int CODE_MASK = (1<<NDIM)-1;
+  static const int N_CODES = 1<<NDIM;
+  static const int N_STATES = NDIM<<NDIM;
+  // The number of levels that fit in a 64 bits chunk of the key
+  static const int CHUNK_LEVELS = (NDIM<64)?(64/NDIM):1;
+
+  struct Tables
+  {
+    /* Entries are indexed by state*N_CODES + code, and each contains the 
+       resulting code in its lower NDIM bits and the next state*N_CODES above.
+       encode maps the NDIM coordinates bits of a level to NDIM bits of the key,
+       and decode is its inverse. The initial state is 0.
+    */
+    unsigned int encode[N_STATES*N_CODES];
+    unsigned int decode[N_STATES*N_CODES];
+    // spread[j] selects the bits of coordinate j in an interleaved chunk
+    Chunk spread[NDIM];
+
+    Tables()
+    {
+      for (int xJ=0;xJ<NDIM;++xJ)
+	for (HCT W=0;W<N_CODES;++W)
+	  {
+	    const unsigned int state=(xJ*N_CODES+W)*N_CODES;
+	    for (HCT A=0;A<N_CODES;++A)
+	      {
+		HCT P=calc_P2(calc_tS_tT(xJ,A^W));
+		HCT nextW=W^calc_tS_tT(xJ,calc_T(P));
+		HCT nextXJ=(xJ+calc_J(P)-1)%NDIM;
+		unsigned int next=(nextXJ*N_CODES+nextW)*N_CODES;
+		encode[state+A] = P | (next<<NDIM);
+		decode[state+P] = A | (next<<NDIM);
+	      }
+	  }
+      
+      for (int j=0;j<NDIM;++j)
+	{
+	  spread[j]=0;
+	  for (int l=0;l<CHUNK_LEVELS;++l)
+	    spread[j] |= Chunk(1)<<(l*NDIM+NDIM-1-j);
+	}
+    }
+  };
+
+  static const Tables &tables()
+  {
+    static const Tables t;
+    return t;
+  }
+
+  static Chunk lowBits(int n)
+  {
+    return (n<64)?((Chunk(1)<<n)-1):(~Chunk(0));
+  }
+
+  // Interleave bits [l0,l0+n[ of the coordinates so that the bit l0+l of
+  // coordinate j is at position l*NDIM+NDIM-1-j
+  static Chunk interleave(const Index *pt, int l0, int n, const Tables &t)
+  {
+    Chunk result=0;
+#ifdef PEANO_HILBERT_USE_BMI2
+    const Chunk m=lowBits(n*NDIM);
+    for (int j=0;j<NDIM;++j)
+      result |= _pdep_u64(static_cast<Chunk>(pt[j])>>l0,t.spread[j]&m);
+#else
+    for (int j=0;j<NDIM;++j)
+      {
+	const Chunk c=static_cast<Chunk>(pt[j])>>l0;
+	for (int l=0;l<n;++l)
+	  result |= ((c>>l)&1)<<(l*NDIM+NDIM-1-j);
+      }
+#endif
+    return result;
+  }
+
+  // Inverse of interleave, sets bits [l0,l0+n[ of the coordinates
+  static void deinterleave(Chunk c, Index *pt, int l0, int n, const Tables &t)
+  {
+#ifdef PEANO_HILBERT_USE_BMI2
+    const Chunk m=lowBits(n*NDIM);
+    for (int j=0;j<NDIM;++j)
+      pt[j] |= static_cast<Index>(_pext_u64(c,t.spread[j]&m)<<l0);
+#else
+    for (int j=0;j<NDIM;++j)
+      {
+	Chunk result=0;
+	for (int l=0;l<n;++l)
+	  result |= ((c>>(l*NDIM+NDIM-1-j))&1)<<l;
+	pt[j] |= static_cast<Index>(result<<l0);
+      }
+#endif
+  }
+
+  // Set the n bits of the key starting at bit pos (key words store order bits each)
+  static void setBits(HCode &h, int pos, Chunk bits, int n, int order)
+  {
+    while (n>0)
+      {
+	const int w=pos/order;
+	const int b=pos%order;
+	const int nw=std::min(n,order-b);
+	h.hcode[w] |= static_cast<Index>((bits&lowBits(nw))<<b);
+	bits = (nw<64)?(bits>>nw):0;
+	pos+=nw;
+	n-=nw;
+      }
+  }
+
+  // Get the n bits of the key starting at bit pos
+  static Chunk getBits(const HCode &h, int pos, int n, int order)
+  {
+    Chunk result=0;
+    int shift=0;
+    while (n>0)
+      {
+	const int w=pos/order;
+	const int b=pos%order;
+	const int nw=std::min(n,order-b);
+	result |= ((static_cast<Chunk>(h.hcode[w])>>b)&lowBits(nw))<<shift;
+	shift+=nw;
+	pos+=nw;
+	n-=nw;
+      }
+    return result;
+  }
+
+  /*===========================================================*/
+  /* H_encode */
+  /*===========================================================*/
+  /* For mapping from NDIM dimensions to one dimension */
+  static HCode H_encode(const Index *pt, int order=maxOrder)
+  {
+    const Tables &t=tables();
+    HCode h = {{0}};
+    unsigned int state=0;
+    // levels are processed from the top, by chunks of at most CHUNK_LEVELS
+    for (int top=order;top>0;top-=CHUNK_LEVELS)
+      {
+	const int n=std::min(top,CHUNK_LEVELS);
+	const int l0=top-n;
+	const Chunk in=interleave(pt,l0,n,t);
+	Chunk out=0;
+	for (int l=n-1;l>=0;--l)
+	  {
+	    const unsigned int e=t.encode[state|((in>>(l*NDIM))&CODE_MASK)];
+	    out |= static_cast<Chunk>(e&CODE_MASK)<<(l*NDIM);
+	    state=e>>NDIM;
+	  }
+	setBits(h,l0*NDIM,out,n*NDIM,order);
+      }
+    return h;
+  }
+
+  static HCode H_encode(const Point &pt, int order=maxOrder)
+  {
+    return H_encode(pt.hcode,order);
+  }
+
+  /*===========================================================*/
+  /* H_decode */
+  /*===========================================================*/
+  /* For mapping from one dimension to NDIM dimensions */
+  static Point H_decode(const HCode &H, int order=maxOrder)
+  {
+    const Tables &t=tables();
+    Point pt = {{0}};
+    unsigned int state=0;
+    for (int top=order;top>0;top-=CHUNK_LEVELS)
+      {
+	const int n=std::min(top,CHUNK_LEVELS);
+	const int l0=top-n;
+	const Chunk in=getBits(H,l0*NDIM,n*NDIM,order);
+	Chunk out=0;
+	for (int l=n-1;l>=0;--l)
+	  {
+	    const unsigned int e=t.decode[state|((in>>(l*NDIM))&CODE_MASK)];
+	    out |= static_cast<Chunk>(e&CODE_MASK)<<(l*NDIM);
+	    state=e>>NDIM;
+	  }
+	deinterleave(out,pt.hcode,l0,n,t);
+      }
+    return pt;
+  }
+
+  // From here, this is an adapted version of J.K. Lawder, 2000, which is used to
+  // build the transition tables.
   /*
     This code assumes the following:
     The macro ORDER corresponds to the order of curve and is 32,
@@ -176,33 +449,6 @@ typedef HCode Point;
     etc...
   */
 
-  
-  /*===========================================================*/
-  /* calc_P */
-  /*===========================================================*/
-  static HCT calc_P (int i, HCode &H, int order=maxOrder)
-  {
-    int element;
-    HCT P, temp1, temp2;
-    element = i / order;
-    P = H.hcode[element];
-    if (i % order > order - NDIM)
-      {
-	temp1 = H.hcode[element + 1];
-	P >>= i % order;
-	temp1 <<= order - i % order;
-	P |= temp1;
-      }
-    else
-      P >>= i % order; /* P is a NDIM bit hcode */
-    /* the & masks out spurious highbit values */
-
-    if (NDIM<order)
-      P &= (1 << NDIM) -1;
-
-    return P;
-  }
-
   /*===========================================================*/
   /* calc_P2 */
   /*===========================================================*/
@@ -264,106 +510,6 @@ typedef HCode Point;
     return retval;
   }
 
-  /*===========================================================*/
-  /* H_decode */
-  /*===========================================================*/
-  /* For mapping from one dimension to NDIM dimensions */
-  static Point H_decode (HCode &H, int order=maxOrder)
-  {
-    HCT mask = HCT(1) << order - 1,
-      A, W = 0, S, tS, T, tT, J, P = 0, xJ;
-    Point pt = {0};
-    int i = order * NDIM - NDIM, j;
-    P = calc_P(i, H);
-    J = calc_J(P);
-    xJ = J - 1;
-    A = S = tS = P ^ P / 2;
-    T = calc_T(P);
-    tT = T;
-    /*--- distrib bits to coords ---*/
-    for (j = NDIM - 1; P > 0; P >>=1, j--)
-      if (P & 1)
-	pt.hcode[j] |= mask;
-    for (i -= NDIM, mask >>= 1; i >=0; i -= NDIM, mask >>= 1)
-      {
-	P = calc_P(i, H);
-	S = P ^ P / 2;
-	tS = calc_tS_tT(xJ, S);
-	W ^= tT;
-	A = W ^ tS;
-	/*--- distrib bits to coords ---*/
-	for (j = NDIM - 1; A > 0; A >>=1, j--)
-	  if (A & 1)
-	    pt.hcode[j] |= mask;
-	if (i > 0)
-	  {
-	    T = calc_T(P);
-	    tT = calc_tS_tT(xJ, T);
-	    J = calc_J(P);
-	    xJ += J - 1;
-	  }
-      }
-    return pt;
-  }
-
-  /*===========================================================*/
-  /* H_encode */
-  /*===========================================================*/
-  /* For mapping from NDIM dimensions to one dimension */
-  static HCode H_encode(Point &pt, int order=maxOrder)
-  {
-    HCT mask = (HCT)1 << (order - 1), element,
-      A, W = 0, S, tS, T, tT, J, P = 0, xJ;
-    HCode h = {{0}};
-    int i = order * NDIM - NDIM, j;
-    for (j = A = 0; j < NDIM; j++)
-      if (pt.hcode[j] & mask)
-	A |= g_mask(j);
-    S = tS = A;
-    P = calc_P2(S);
-    /* add in NDIM bits to hcode */
-    element = i / order;
-    if (i % order > order - NDIM)
-      {
-	h.hcode[element] |= P << (i % order);
-	h.hcode[element + 1] |= P >> (order - (i % order));
-      }
-    else
-      h.hcode[element] |= P << (i - element * order);
-    J = calc_J(P);
-    xJ = J - 1;
-    T = calc_T(P);
-    tT = T;
-    for (i -= NDIM, mask >>= 1; i >=0; i -= NDIM, mask >>= 1)
-      {
-	for (j = A = 0; j < NDIM; j++)
-	  if (pt.hcode[j] & mask)
-	    A |= g_mask(j);
-	W ^= tT;
-	tS = A ^ W;
-	S = calc_tS_tT(xJ, tS);
-	P = calc_P2(S);
-	/* add in NDIM bits to hcode */
-	element = i / order;
-	if (i % order > order - NDIM)
-	  {
-	    h.hcode[element] |= P << i % order;
-	    h.hcode[element + 1] |= P >> (order - i % order);
-	  }
-	else
-	  h.hcode[element] |= P << (i - element * order);
-	if (i > 0)
-	  {
-	    T = calc_T(P);
-	    tT = calc_tS_tT(xJ, T);
-	    J = calc_J(P);
-	    xJ += J - 1;
-	  }
-      }
-    return h;
-  }
-
-  
 };
 
 /** \}*/
@@ -2,6 +2,7 @@
 #define __COLDICE_HXX__
 
 #include <limits> 
+#include <numeric>
 //#include <random>
 
 #include "units.hxx"
@@ -121,6 +122,7 @@ public:
 
   typedef MeshAndTracersCoordsT<Mesh> MeshAndTracersCoords;
   typedef typename MeshAndTracersCoords::iterator MeshAndTracersCoords_iterator;
+  typedef MeshAndTracersBinnedCoordsT<Mesh> MeshAndTracersBinnedCoords;
 
   typedef typename Simplex::Neighborhood SimplexNeighborhood;
 
@@ -130,7 +132,7 @@ public:
 
   static std::string parserCategory() {return "solver";}
   static std::string classHeader() {return "vlasov_poisson_solver";}
-  static float classVersion() {return 0.24;}
+  static float classVersion() {return 0.28;}
   static float compatibleSinceClassVersion() {return 0.17;}
 
   template <class SP, class R, class PM>
@@ -306,6 +308,15 @@ public:
 	      PM::PARSER_FIRST,
 	      "Value of the CFL condition (fraction of a FFT grid pixel size)");
       }
+
+    timeBins = 1;
+    timeBins = paramsManager.
+      get("timeBins",parserCategory(),timeBins,reader,
+	  PM::PARSER_FIRST,
+	  "Number of levels in the hierarchy of time steps (1 for a single global time step). When the CFL condition is enforced, it is relaxed by a factor 2^(timeBins-1) for the global time step and vertices and tracers that would move too fast are sub-cycled with time steps down to dt/2^(timeBins-1). The potential is still computed once per time step, but it is gathered at each sub-step only for the coordinates that are advanced.",
+	  serializedVersion>0.265);
+    if (timeBins<1) timeBins=1;
+    timeBinVelocity=0;
     
     fileDumps.parseFromManager(paramsManager,reader,classVersion(),serializedVersion);
     
@@ -338,6 +349,13 @@ public:
       get("splitLongestEdge",parserCategory(),splitLongestEdge,reader,
 	  PM::PARSER_FIRST,
 	  "Set to split the longest longest edge when refining instead of trying to minimize the invariant");
+
+    isotropicRefinement = 0;
+    isotropicRefinement = paramsManager.
+      get("isotropicRefinement",parserCategory(),isotropicRefinement,reader,
+	  PM::PARSER_FIRST,
+	  "Set to split segments following a predefined bisection order (longest edge in lagrangian coordinates, i.e. Maubach's bisection for the initial Kuhn tesselation), refining neighbors first when needed so that simplices remain isotropic. Overrides 'splitLongestEdge'.",
+	  serializedVersion>0.255);
     
     maxSimplexLevel = -1;
     maxSimplexLevel = paramsManager.
@@ -359,6 +377,13 @@ public:
 	  PM::PARSER_FIRST,
 	  "Maximum (approximate) amount of memory in GigaBytes reserved for gathering the potential on local MPI processes. The larger, the faster, multiple passes being used to compensate for the lack of memory if needed. Set to 0 for unlimited, which amounts to allocating locally a grid equivalent to the FFT grid ( = 2^(NDIM*fftGridLevel)*sizeof(double) bytes). THIS OPTION IS DISABLED FOR NOW.",
 	  serializedVersion>0.215);
+
+    gatheredPotentialNodeShared = 0;
+    gatheredPotentialNodeShared = paramsManager.
+      get("gatheredPotentialNodeShared",parserCategory(),gatheredPotentialNodeShared,reader,
+	  PM::PARSER_FIRST,
+	  "Set to 1 to gather the potential only once per node in a buffer shared by all the MPI processes of the node (requires MPI-3). This reduces memory usage and inter-node communications by the number of processes per node.",
+	  serializedVersion>0.245);
     
     fftGridLevel = D_AMR_ROOT_LEVEL+2;
     fftGridLevel = paramsManager.
@@ -447,6 +472,20 @@ public:
 	  "If true, MPI regions weight is directly proportional to the number of simplices.",
 	  serializedVersion>0.175); 
 
+    repartProjectionCost=0;
+    repartProjectionCost=paramsManager.
+      get("repartProjectionCost",parserCategory(),repartProjectionCost,reader,
+	  PM::PARSER_FIRST,
+	  "If true (and noRepartWeight is false), the projection time is attributed to MPI regions according to the work measured for each simplex during the last projection, so that regions that are expensive to project (e.g. caustics) are spread over processes.",
+	  serializedVersion>0.27); 
+
+    repartPHOrder=0;
+    repartPHOrder=paramsManager.
+      get("repartPHOrder",parserCategory(),repartPHOrder,reader,
+	  PM::PARSER_FIRST,
+	  "If true, repartitioning cuts the Peano-Hilbert curve used to sort the local meshes (see phSortThreshold) into ranges of equal weight using a distributed sample sort, so that each MPI process holds a contiguous range of the curve and the mesh is globally ordered.",
+	  serializedVersion>0.275); 
+
     sprintf(comment,"Required accuracy level for projection %s",
 	    D_ENABLE_ACCURACY_CHECKING?"(ENABLED).":"(DISABLED). Use D_ENABLE_ACCURACY_CHECKING compile time option to enable.");
     accuracyLevel = 1.E-3;
@@ -568,41 +607,54 @@ public:
       (v1->getCoordsConstPtr(),v2->getCoordsConstPtr()) <= coarsenThreshold2;
   }
   
-  double checkRefine_getValue(Simplex *s)
+  template <class S>
+  void checkRefine_getValues(S * const *s, long n, double *result)
   {
-    double result=0;
+    dice::slv::refine::
+      poincareInvariantWithSegTracers_order1_batch<Mesh>(s,n,geometry,result);
     
-    if ((maxSimplexLevel<0)||(s->getLevel()<maxSimplexLevel))
+    for (long i=0;i<n;++i)
       {
-	result = dice::slv::refine::
-	  poincareInvariantWithSegTracers_order1<Mesh>(s,geometry).first;
+	if ((maxSimplexLevel>=0)&&(s[i]->getLevel()>=maxSimplexLevel))
+	  {
+	    result[i]=0;
+	    continue;
+	  }
 	
 #if D_PER_SIMPLEX_INVARIANT
 	if (perSimplexInvariant)
 	  {
-	    if (result < s->invariantThreshold.getValue()*invariantFactor)
-	      result=0;
+	    if (result[i] < s[i]->invariantThreshold.getValue()*invariantFactor)
+	      result[i]=0;
 	  }
 	else
 	  {
-	    result *= invariantThreshold_invWithFactor;
-	    if (result < 1) result=0;
+	    result[i] *= invariantThreshold_invWithFactor;
+	    if (result[i] < 1) result[i]=0;
 	  }
 #endif
-	result *= invariantThreshold_invWithFactor;
-	if (result < 1) result=0;
+	result[i] *= invariantThreshold_invWithFactor;
+	if (result[i] < 1) result[i]=0;
       }
-    
-    return result;
   }
   
+  bool checkRefine_predefinedOrder() const
+  {
+    return isotropicRefinement;
+  }
+
   //CheckRefineReturnType 
   int checkRefine_getSplitSegmentIndex(Simplex *s, double &oldVal)
   {   
     int ret;
     
     // invariant is above the threshold, this simplex should be refined !
-    if (splitLongestEdge)
+    if (isotropicRefinement)
+      {
+	// Follow the predefined bisection order
+	ret=dice::slv::refine::predefinedBisectionSegment<Mesh>(s,geometry).second;
+      }
+    else if (splitLongestEdge)
       {
 	// Just refine the longest edge ...
 	//ret = dice::slv::refine::length2<Mesh>(s,geometry).second; // Eulerian 
@@ -792,7 +844,10 @@ public:
   // This function should return the TOTAL weight for the local region
   // For default weighting, return 0.
   // Set force to true to enforce repartitionning
-  double onCheckRepartLocalWeight(double stepDuration, bool &force)
+  // rootWeights may optionally be set to the weight of each root of the mesh tree 
+  // (see Mesh::getRootSums()), in which case the returned value is ignored.
+  double onCheckRepartLocalWeight(double stepDuration, bool &force,
+				  std::vector<double> &rootWeights)
   {
     if (noRepartWeight) return 0;
 
@@ -805,6 +860,25 @@ public:
     
     // We may have (otherWeight<0) when using e.g. static potential solver
     double result = (otherWeight<0)?0:(otherWeight + projectWeight)*mesh->getNSimplices();
+
+    // The projection cost measured for each root is still valid if the mesh was not
+    // repartitioned since the last projection (see afterRepart())
+    if ((result>0)&&(rootProjectionCost.size()>0))
+      {
+	double costSum=std::accumulate(rootProjectionCost.begin(),
+				       rootProjectionCost.end(),0.0);
+	// Distribute the projection time according to the measured work
+	mesh->getRootSums(NULL,rootWeights);
+	for (unsigned long i=0;i<rootWeights.size();++i)
+	  {
+	    double nCells=rootWeights[i];
+	    if (costSum>0)
+	      rootWeights[i] = otherWeight*nCells + 
+		projectDuration*(rootProjectionCost[i]/costSum);
+	    else
+	      rootWeights[i] = (otherWeight + projectWeight)*nCells;
+	  }
+      }
     
     return result;
 
@@ -812,11 +886,29 @@ public:
     //return -1;
   }
 
+  // Called when the mesh needs to be repartitioned, with the weight of each root of
+  // the mesh tree. Return true after setting partition to the new rank of each root 
+  // to bypass the default partitioner.
+  bool onRepartRootPartition(const std::vector<double> &rootWeights,
+			     std::vector<typename Mesh::PartitionerIndex> &partition)
+  {
+    if (!repartPHOrder) return false;
+
+    // Cut the curve defined by the keys used by sortMesh()
+    std::vector<typename PHSimplexKey::HCode> rootKeys;
+    mesh->getRootKeys(PHSimplexKey(mesh),rootKeys);
+    dice::Partitioner::repartSampleSort(rootKeys,rootWeights,partition,mpiCom);
+    return true;
+  }
+
   // status is true if the GLOBAL mesh was repartitionned 
   void afterRepart(bool status)
   {
     repartStatus=status;
     
+    // The roots of the mesh tree changed
+    if (status) rootProjectionCost.clear();
+
     // If the mesh was repartitionned, we should always sort it locally ...
     if (status) sortMesh();
     else 
@@ -901,6 +993,17 @@ protected:
 	dice::glb::console->printFlush<dice::LOG_STD>("done.\n");
       }
     
+    if (gatheredPotentialNodeShared)
+      {
+	if (potential.setNodeSharedGather(true))
+	  dice::glb::console->print<dice::LOG_STD>
+	    ("Potential will be gathered once per node (%d processes on this node).\n",
+	     mpiCom->nodeSize());
+	else
+	  dice::glb::console->print<dice::LOG_STD>
+	    ("Potential will be gathered once per process (node shared memory unavailable).\n");
+      }
+    
     // Setup some global parameters
     updateInvariantThreshold(t);
     refineThreshold2 = refineThreshold * (p.delta[0]/(1<<fftGridLevel) * sqrt(NDIM));
@@ -915,6 +1018,7 @@ protected:
     updateDensityTimer  = dice::glb::timerPool->pop("updateDensity");    
     projectTimer   = dice::glb::timerPool->pop("project");
     projectBarrierTimer = dice::glb::timerPool->pop("project_barrier");
+    projectionStatisticsPending=false;
     kickAndDriftTimer = dice::glb::timerPool->pop("kickDrift");
     driftTimer = dice::glb::timerPool->pop("drift");    
     fftSolverTimer = dice::glb::timerPool->pop("FFT");
@@ -1159,38 +1263,51 @@ protected:
     dice::glb::console->print<dice::LOG_STD>(" done.\n");
   }
   
-  // Sort the local mesh along a peano hilbert curve
-  void sortMesh()
-  {       
+  // A functor that takes a simplex and returns its lagrangian coordinates along 
+  // a peano hilbert curve spanning the bounding box of the mesh
+  struct PHSimplexKey
+  {
     typedef typename dice::PeanoHilbertT<NDIM> PH;
-    double x0[NDIM];
-    double deltaInv[NDIM];
-    mesh->getBoundingBox(x0,deltaInv,false); 
-    
-    for (int i=0;i<NDIM;++i) 
-      deltaInv[i]=1.0/deltaInv[i];
-    
-    // A functor that takes a simplex and returns it lagrangian coordinates along 
-    // a peano hilbert curve
-    auto sf=[x0,deltaInv](Simplex *s) -> typename PH::HCode
-      {
-	typename PH::HCode result;
+    typedef typename PH::HCode HCode;
 
-	// Coords are the barycenter of lagrangian vertices coordinates
-	Coord c[NDIM]={0};
-	for (int i=0;i<Simplex::NVERT;++i)
-	  {
-	    const Coord *vc=s->getVertex(i)->initCoords.getPointer();
-	    for (int j=0;j<NDIM;++j)
-	      c[j] += vc[j];
-	  }
+    PHSimplexKey(Mesh *mesh)
+    {
+      mesh->getBoundingBox(x0,deltaInv,false); 
+      for (int i=0;i<NDIM;++i) 
+	deltaInv[i]=1.0/deltaInv[i];
+    }
+
+    HCode operator()(Simplex *s) const
+    {
+      HCode result;
+
+      // Coords are the barycenter of lagrangian vertices coordinates
+      Coord c[NDIM]={0};
+      for (int i=0;i<Simplex::NVERT;++i)
+	{
+	  const Coord *vc=s->getVertex(i)->initCoords.getPointer();
+	  for (int j=0;j<NDIM;++j)
+	    c[j] += vc[j];
+	}
 	    	    
-	for (int i=0;i<NDIM;++i)
-	  c[i]=c[i]/Simplex::NVERT;
+      for (int i=0;i<NDIM;++i)
+	c[i]=c[i]/Simplex::NVERT;
 		
-	PH::coordsToLength(c,result,x0,deltaInv);
-	return result;
-      };
+      PH::coordsToLength(c,result,x0,deltaInv);
+      return result;
+    }
+
+    double x0[NDIM];
+    double deltaInv[NDIM];
+  };
+
+  // Sort the local mesh along a peano hilbert curve
+  void sortMesh()
+  {       
+    typedef typename dice::PeanoHilbertT<NDIM> PH;
+    const PHSimplexKey sf(mesh);
+    const double *x0=sf.x0;
+    const double *deltaInv=sf.deltaInv;
 
     // A functor that takes a vertex and returns it coordinates along a peano 
     // hilbert curve
@@ -1342,6 +1459,12 @@ protected:
     updateProjectedDensityField();
     ****************/
 
+    // Measure the work needed to project each simplex if we need it for repartitioning
+    std::vector<double> simplexProjectionCost;
+    std::vector<double> *simplexCost=NULL;
+    if ((repartProjectionCost)&&(!noRepartWeight)&&(mpiCom->size()>1)) 
+      simplexCost=&simplexProjectionCost;
+
     projectTimer->start(); 
     if (projectionOrder==0)
       {
@@ -1354,7 +1477,8 @@ protected:
 	  (mesh,projectedDensityFunctor,accuracyLevel,
 	   (fastAmrBuild)?true:false, // Use simplex tags
 	   dice::glb::num_omp_threads,
-	   true); 	   
+	   true,
+	   simplexCost); 	   
       }
     else
       {
@@ -1370,39 +1494,29 @@ protected:
 	   accuracyLevel,
 	   (fastAmrBuild)?true:false, // Use simplex tags
 	   dice::glb::num_omp_threads,
-	   true); 
+	   true,
+	   simplexCost); 
       }
     double elapsed=projectTimer->stop();
 
-    // Synchronize MPI processes if necessary
-    // This gives us a measure of the projection imbalance.
-    if (mpiCom->size() > 1)
-      {
-	projectBarrierTimer->start();
-	dice::glb::console->printFlush<dice::LOG_STD>("Synchronizing MPI processes ... ");
-	
-	// This will force a synchronisation anyway, so no need for the barrier
-	auto mms = mpiCom->minMaxSum<double,true>(elapsed);
-	mpiCom->sum(reprojectedSimplicesCount);
+    // The roots are not modified until the next repartitioning, contrary to the 
+    // simplices, so we keep the cost of each root
+    if (simplexCost!=NULL) mesh->getRootSums(simplexCost,rootProjectionCost);
 
-	double min = mms.first.first;
-	double max = mms.first.second;
-	double avg = mms.second / mpiCom->size();
-	double imbalance = max / avg;
-
-	double projectBarrierWaitDuration = projectBarrierTimer->stop();
-	dice::glb::console->printFlush<dice::LOG_STD>
-	  ("done in %.3lgs.\n",projectBarrierWaitDuration);
-	dice::glb::console->printFlush<dice::LOG_STD>
-	  ("Global projection imbalance factor: %.3lg (Tmin=%.3lgs, Tmax=%.3lgs, Tavg=%.3lgs).\n",imbalance,min,max,avg);	
-      }
-
-    if (reprojectedSimplicesCount > pEnableHRModeThreshold * mesh->getGlobalNCells(NDIM))
+    // The projection statistics are not needed until the potential has been computed,
+    // so they are reduced in a single non blocking call and the processes do not need 
+    // to synchronize here (see reportProjectionStatistics()).
+    projectionTimes[0]=projectionTimes[1]=projectionTimes[2]=elapsed;
+    reprojectedSimplicesTotal=reprojectedSimplicesCount;
+    if (mpiCom->size() > 1)
       {
-	dice::glb::console->print<dice::LOG_WARNING>
-	  ("Reprojected simplices threshold reached, switching high resolution projection mode ON.\n");	
-	pForceHighResolution=!pForceHighResolution;
+	mpiCom->deferReduction(&projectionTimes[0],MPI_MIN);
+	mpiCom->deferReduction(&projectionTimes[1],MPI_MAX);
+	mpiCom->deferReduction(&projectionTimes[2],MPI_SUM);
+	mpiCom->deferReduction(&reprojectedSimplicesTotal,MPI_SUM);
+	mpiCom->startDeferredReductions();
       }
+    projectionStatisticsPending=true;
 
     if (checkProjectedDensity)
       {
@@ -1504,6 +1618,40 @@ protected:
     return pass;
   }
  
+  // Complete the reduction of the projection statistics started in projectMesh(),
+  // report the projection imbalance and switch the high resolution mode if needed.
+  void reportProjectionStatistics()
+  {
+    if (!projectionStatisticsPending) return;
+    projectionStatisticsPending=false;
+
+    if (mpiCom->size() > 1)
+      {
+	projectBarrierTimer->start();
+	dice::glb::console->printFlush<dice::LOG_STD>("Gathering projection statistics ... ");
+	
+	mpiCom->finishDeferredReductions();
+
+	double min = projectionTimes[0];
+	double max = projectionTimes[1];
+	double avg = projectionTimes[2] / mpiCom->size();
+	double imbalance = max / avg;
+
+	double projectBarrierWaitDuration = projectBarrierTimer->stop();
+	dice::glb::console->printFlush<dice::LOG_STD>
+	  ("done in %.3lgs.\n",projectBarrierWaitDuration);
+	dice::glb::console->printFlush<dice::LOG_STD>
+	  ("Global projection imbalance factor: %.3lg (Tmin=%.3lgs, Tmax=%.3lgs, Tavg=%.3lgs).\n",imbalance,min,max,avg);	
+      }
+
+    if (reprojectedSimplicesTotal > pEnableHRModeThreshold * mesh->getGlobalNCells(NDIM))
+      {
+	dice::glb::console->print<dice::LOG_WARNING>
+	  ("Reprojected simplices threshold reached, switching high resolution projection mode ON.\n");	
+	pForceHighResolution=!pForceHighResolution;
+      }
+  }
+
   void solvePoisson(double t)
   {    
     double elapsed;    
@@ -1522,6 +1670,7 @@ protected:
     else dice::glb::console->print<dice::LOG_STD>("Solving poisson equation:\n");
 
     dice::glb::console->indent();
+    dice::internal::MpiCallProfilerPhase profilerPhase(mpiCom->getCallProfiler(),"poisson");
     solvePoissonTimer->start();
 
     // Compute projected density and its gradient over the mesh
@@ -1782,6 +1931,9 @@ protected:
 	  (oldSolverDeltaT+curSolverDeltaT);
       }
     else expansionEnergy=0;
+
+    // The FFT already synchronized the processes, so this should not need to wait
+    reportProjectionStatistics();
   
     elapsed=solvePoissonTimer->stop();
     dice::glb::console->unIndent();
@@ -1802,9 +1954,9 @@ protected:
     dice::hlp::FpuRoundingModeGuardT<CT> fpuGuard;
   
 #ifdef D_TRADE_MEMORY_FOR_SPEED
-    std::vector<double> vertexVolume(mesh->getNVertices()*2*nThreads,0);    
+    dice::ScratchVectorT<double>::Type vertexVolume(mesh->getNVertices()*2*nThreads,0);    
 #else
-    std::vector<double> vertexVolume(mesh->getNVertices(),0);
+    dice::ScratchVectorT<double>::Type vertexVolume(mesh->getNVertices(),0);
     
     // Reset vertices density
     FOREACH_THREAD_VERTEX(mesh,nThreads,th,it)
@@ -2014,6 +2166,8 @@ protected:
     double upperLimit=dtMax;
     double oldDt=dt;
     double velocityMax = getVelocityMax();
+    // fast vertices are sub-cycled, so the CFL condition is relaxed accordingly
+    double binsFactor = (1L<<(timeBins-1));
     
     double cflFactor=units.length/units.velocity;
     const double pi=4.0*atan(1.0);
@@ -2036,12 +2190,13 @@ protected:
     if (cflCondition == CflConditionTypeV::CFL_RHOMAX)
       {
 	double dt1 = (cflRhoMax/sqrt(densityMax*densityFactor));
-	double dt2 = (cflSizeMax/velocityMax)*cflFactor;
+	double dt2 = (cflSizeMax/velocityMax)*cflFactor*binsFactor;
 	
 	dt = std::min(dt1,dt2);
 	dt = std::min(dt,upperLimit);
 
 	dt=mpiCom->min(dt);    
+	timeBinVelocity = (cflSizeMax*cflFactor)/dt;
 	dice::glb::console->print<dice::LOG_STD>
 	  ("Updated time step (dtMax=%g): dt=%g->%g (rhoMax=%e,dt=%g)/(vMax=%e,dt=%g)\n",
 	   upperLimit,oldDt,dt,densityMax,dt1,velocityMax,dt2);
@@ -2052,6 +2207,7 @@ protected:
 	dt = std::min(dt,upperLimit);
 
 	dt=mpiCom->min(dt);    
+	timeBinVelocity = 0;
 	dice::glb::console->print<dice::LOG_STD>
 	  ("Updated time step (dtMax=%g): dt=%g->%g (rhoMax=%e)\n",
 	   upperLimit,oldDt,dt,densityMax);
@@ -2061,11 +2217,12 @@ protected:
 	if (velocityMax==0) 
 	  dt = upperLimit;
 	else
-	  dt = (cflSizeMax/velocityMax)*cflFactor;
+	  dt = (cflSizeMax/velocityMax)*cflFactor*binsFactor;
 
 	dt = std::min(dt,upperLimit);
 
 	dt=mpiCom->min(dt);    
+	timeBinVelocity = (cflSizeMax*cflFactor)/dt;
 	dice::glb::console->print<dice::LOG_STD>
 	  ("Updated time step (dtMax=%g): dt=%g->%g (vMax=%e)\n",
 	   upperLimit,oldDt,dt,velocityMax);
@@ -2217,6 +2374,13 @@ protected:
 
   template <class CC>
   void kick_drift(double dt, CC &coordContainer)
+  {
+    kick_drift(curSolverTime,dt,coordContainer);
+  }
+
+  // kick from t to t+dt, then drift by dt/2
+  template <class CC>
+  void kick_drift(double t, double dt, CC &coordContainer)
   {
 #pragma omp parallel num_threads(dice::glb::num_omp_threads)
     {LIKWID_MARKER_START("KickDrift");}
@@ -2230,8 +2394,8 @@ protected:
 
     if (units.useCosmo)
       {
-	double a0=units.cosmology.a_of_tau(curSolverTime,aStart,1.E-8,aEnd*2);
-	double a1=units.cosmology.a_of_tau(curSolverTime + curSolverDeltaT,aStart,1.E-8,aEnd*2);
+	double a0=units.cosmology.a_of_tau(t,aStart,1.E-8,aEnd*2);
+	double a1=units.cosmology.a_of_tau(t + dt,aStart,1.E-8,aEnd*2);
 	 
 	velFactor = a0/a1;
 	// h0 -> H0 in s-1	
@@ -2273,6 +2437,149 @@ protected:
     {LIKWID_MARKER_STOP("KickDrift");}
   }
 
+  // drift the coordinates in coordContainer by dt (and not dt/2 as in drift()), 
+  // the expansion factor being evaluated at time t.
+  template <class CC>
+  void drift_coords(double t, double dt, CC &coordContainer)
+  {
+    int nThreads=std::min(dice::glb::num_omp_threads,D_N_THREADS_MAX_DRIFT);
+    
+    double driftFactor=1.0/(units.length/units.velocity);
+    if (units.useCosmo)
+      driftFactor*=units.cosmology.a_of_tau(t,aStart,1.E-8,aEnd*2)/units.H;
+
+#pragma omp parallel for num_threads(nThreads)
+    for (int j=0;j<nThreads;j++)
+      {
+	const auto it_end = coordContainer.end(j,nThreads);
+	for (auto it = coordContainer.begin(j,nThreads);it!=it_end;++it)
+	  {
+	    Coord *c=*it;
+	    for (int i=0;i<NDIM;++i)
+	      c[i]+=c[i+NDIM]*driftFactor*dt;
+	    geometry->sanitizeBoundary(c);
+	  }
+      }
+  }
+
+  // Returns the time bin of a coordinate: it is advanced with a time step 
+  // dt/2^bin such that it moves less than the CFL condition allows
+  struct TimeBinSelector
+  {
+    TimeBinSelector(double velocity, int maxBin_):
+      velocityInv((velocity>0)?1.0/velocity:0),
+      maxBin(maxBin_)
+    {}
+
+    int operator()(const Coord *c) const
+    {
+      double v=0;
+      for (int i=0;i<NDIM;++i) 
+	if (fabs(c[i+NDIM])>v) v=fabs(c[i+NDIM]);
+
+      double ratio=v*velocityInv;
+      int bin=0;
+      while ((ratio>1.0)&&(bin<maxBin))
+	{
+	  ratio*=0.5;
+	  ++bin;
+	}
+      return bin;
+    }
+
+    const double velocityInv;
+    const int maxBin;
+  };
+
+  // Number of time bins actually needed by all the coordinates at the current step
+  int getTimeBinsCount(const TimeBinSelector &selector)
+  {
+    if ((timeBins<2)||(timeBinVelocity<=0)) return 1;
+
+    MeshAndTracersCoords coordContainer(mesh);
+    int maxBin=0;
+#pragma omp parallel for num_threads(dice::glb::num_omp_threads) reduction(max:maxBin)
+    for (int j=0;j<dice::glb::num_omp_threads;j++)
+      {
+	const auto it_end = coordContainer.end(j,dice::glb::num_omp_threads);
+	for (auto it = coordContainer.begin(j,dice::glb::num_omp_threads);it!=it_end;++it)
+	  {
+	    int bin=selector(*it);
+	    if (bin>maxBin) maxBin=bin;
+	  }
+      }
+
+    return mpiCom->max(maxBin)+1;
+  }
+
+  /* Gather the potential and advance the coordinates with a hierarchy of nBins time 
+   * steps, coordinates in bin b being advanced 2^b times with a time step dt/2^b. 
+   * The potential computed at mid step is used for all the sub-steps, but it is only
+   * gathered at the coordinates that are currently advanced. All the coordinates 
+   * were already drifted by dt/2 (see drift()), so those in bins b>0 are moved back 
+   * before being sub-cycled.
+   */
+  void kick_drift_multiRate(int nBins, const TimeBinSelector &selector)
+  {
+    MeshAndTracersBinnedCoords coordContainer(mesh,nBins,selector);
+    const double t=curSolverTime;
+    const double dt=curSolverDeltaT;
+    const long nTicks=(1L<<(nBins-1));
+    double elapsedG=0;
+    double elapsedK=0;
+
+    for (long tick=0;tick<nTicks;++tick)
+      {
+	// bins with a sub-step starting at this tick (bin nBins-1 is always active)
+	int firstBin=0;
+	if (tick)
+	  {
+	    int tz=0;
+	    while (!((tick>>tz)&1)) ++tz;
+	    firstBin=nBins-1-tz;
+	  }
+
+	kickAndDriftTimer->start();
+	for (int bin=std::max(firstBin,1);bin<nBins;++bin)
+	  {
+	    double h=dt/(1L<<bin);
+	    coordContainer.setBins(bin,bin);
+	    if (tick==0)
+	      drift_coords(t,(h-dt)/2,coordContainer);
+	    else
+	      drift_coords(t+h*(tick>>(nBins-1-bin)),h/2,coordContainer);
+	  }
+	elapsedK+=kickAndDriftTimer->stop();
+
+	gatherPotentialTimer->start();
+	coordContainer.setBins(firstBin,nBins-1);
+	potential.template gatherSubsetAtCoords<InterpolationKernel>
+	  (coordContainer,gatheredPotential);
+	elapsedG+=gatherPotentialTimer->stop();
+
+	kickAndDriftTimer->start();
+	for (int bin=firstBin;bin<nBins;++bin)
+	  {
+	    double h=dt/(1L<<bin);
+	    coordContainer.setBins(bin,bin);
+	    kick_drift(t+h*(tick>>(nBins-1-bin)),h,coordContainer);
+	  }
+	elapsedK+=kickAndDriftTimer->stop();
+      }
+
+    std::vector<long> binSize(nBins);
+    for (int bin=0;bin<nBins;++bin) 
+      binSize[bin]=coordContainer.getBinSize(bin);
+    mpiCom->Allreduce_inplace(binSize,MPI_SUM);
+
+    dice::glb::console->printToBuffer<dice::LOG_STD>
+      ("done in %.3gs / %.3gs. (%d time bins: %ld",elapsedG,elapsedK,nBins,binSize[0]);
+    for (int bin=1;bin<nBins;++bin) 
+      dice::glb::console->printToBuffer<dice::LOG_STD>(",%ld",binSize[bin]);
+    dice::glb::console->printToBuffer<dice::LOG_STD>(" coordinates)\n");
+    dice::glb::console->flushBuffer<dice::LOG_STD>();
+  }
+
   void advance_impl()
   { 
     double elapsed;
@@ -2304,6 +2611,9 @@ protected:
 #endif
     
     
+    TimeBinSelector timeBinSelector(timeBinVelocity,timeBins-1);
+    int nTimeBins=getTimeBinsCount(timeBinSelector);
+    
     double maxAlloc=gatheredPotentialAllocLimit*(1L<<30);
     if (MeshAndTracersSliceCoordsT<Mesh>::getSlicesCount(potential,maxAlloc)>1)
       {	
@@ -2334,6 +2644,12 @@ protected:
 	} while ((nRequired!=0)&&(pass<coordContainer.nGroups()));
 	dice::glb::console->unIndent();
       }
+    else if (nTimeBins>1)
+      {
+	// Fast coordinates need to be sub-cycled
+	dice::glb::console->printFlush<dice::LOG_STD>("and advancing (K+D) ... ");
+	kick_drift_multiRate(nTimeBins,timeBinSelector);
+      }
     else
       {
 	// We can afford to allocate the full grid locally
@@ -2550,6 +2866,10 @@ protected:
   typename dice::TimerPool::Timer *amrBuildTimer;
   typename dice::TimerPool::Timer *projectTimer;   
   typename dice::TimerPool::Timer *projectBarrierTimer;  
+  double projectionTimes[3]; // min / max / sum over processes (see projectMesh())
+  long reprojectedSimplicesTotal;
+  bool projectionStatisticsPending;
+  std::vector<double> rootProjectionCost; // work measured for each root of the mesh tree
   typename dice::TimerPool::Timer *kickAndDriftTimer;  
   typename dice::TimerPool::Timer *driftTimer;  
   typename dice::TimerPool::Timer *fftSolverTimer;
@@ -2579,6 +2899,8 @@ protected:
   double cflGrid;
   double cflRhoMax;
   double cflSizeMax;
+  int timeBins;
+  double timeBinVelocity;
 
   dice::RegularGridSymmetryE symmetry;
   std::string symmetryStr;
@@ -2604,6 +2926,7 @@ protected:
   double accuracyLevel;
 
   double gatheredPotentialAllocLimit;
+  int gatheredPotentialNodeShared;
   int fftGridLevel;
   int fftWisdom;
   std::string importFftWisdom;
@@ -2613,9 +2936,12 @@ protected:
   int skipInitialPoisson;
   int dumpInitialMesh;
   int noRepartWeight;
+  int repartProjectionCost;
+  int repartPHOrder;
   int projectionOrder;
 
   int splitLongestEdge;
+  int isotropicRefinement;
   int maxAmrLevel;
   int fastAmrBuild;
 
@@ -324,5 +324,117 @@ private:
   double delta_inv;
 };
 
+/**
+ * \class MeshAndTracersBinnedCoordsT
+ * \brief A dummy container class used to iterate over the vertices and tracers 
+ * coordinates defined in a mesh that belong to a given range of bins (e.g. time step
+ * bins). Coordinates are sorted by bin on construction, and only those in the bins 
+ * selected with setBins() are visited. Each iterator dereferences to a pointer to 
+ * M::Coord.
+ * \tparam M the mesh class 
+ */
+template <class M>
+class MeshAndTracersBinnedCoordsT
+{
+public:
+  typedef MeshAndTracersCoordsT<M> MeshAndTracersCoords;
+  typedef M Mesh;
+  typedef typename Mesh::Coord Coord;
+  typedef typename std::vector<Coord*>::iterator iterator;
+  typedef typename std::vector<Coord*>::const_iterator const_iterator;
+
+  /** \param m the mesh
+   *  \param nBins the number of bins
+   *  \param getBin a functor returning the bin in [0,nBins[ of a coordinate given
+   *  a pointer to it
+   */
+  template <class B>
+  MeshAndTracersBinnedCoordsT(Mesh *m, int nBins, const B &getBin)
+  {
+    MeshAndTracersCoords coordContainer(m);
+    std::vector< std::vector<Coord*> > bins(nBins);
+
+#pragma omp parallel for num_threads(dice::glb::num_omp_threads)
+    for (int j=0;j<dice::glb::num_omp_threads;j++)
+      {
+	std::vector< std::vector<Coord*> > localBins(nBins);
+
+	const auto it_end = coordContainer.end(j,dice::glb::num_omp_threads);
+	for (auto it = coordContainer.begin(j,dice::glb::num_omp_threads);it!=it_end;++it)
+	  localBins[getBin(*it)].push_back(*it);
+
+#pragma omp critical
+	{
+	  for (int i=0;i<nBins;++i)
+	    bins[i].insert(bins[i].end(),localBins[i].begin(),localBins[i].end());
+	}
+      }
+
+    binStart.assign(nBins+1,0);
+    for (int i=0;i<nBins;++i)
+      binStart[i+1]=binStart[i]+bins[i].size();
+
+    coords.reserve(binStart.back());
+    for (int i=0;i<nBins;++i)
+      {
+	coords.insert(coords.end(),bins[i].begin(),bins[i].end());
+	std::vector<Coord*>().swap(bins[i]);
+      }
+
+    setBins(0,nBins-1);
+  }
+
+  int nBins() const
+  {
+    return binStart.size()-1;
+  }
+
+  long getBinSize(int bin) const
+  {
+    return binStart[bin+1]-binStart[bin];
+  }
+
+  //! Only coordinates in bins firstBin to lastBin (included) will be visited
+  void setBins(int firstBin, int lastBin)
+  {
+    first=binStart[firstBin];
+    last=binStart[lastBin+1];
+  }
+
+  iterator begin(int delta=0, int stride=1)
+  {
+    long sz = (last-first)/stride;
+    return coords.begin()+first+sz*delta;
+  }
+
+  iterator end(int delta=0, int stride=1)
+  {
+    if (delta==(stride-1)) return coords.begin()+last;
+
+    long sz = (last-first)/stride;
+    return coords.begin()+first+sz*(delta+1);
+  }  
+
+  const_iterator begin(int delta=0, int stride=1) const
+  {
+    long sz = (last-first)/stride;
+    return coords.cbegin()+first+sz*delta;
+  }
+
+  const_iterator end(int delta=0, int stride=1) const
+  {
+    if (delta==(stride-1)) return coords.cbegin()+last;
+
+    long sz = (last-first)/stride;
+    return coords.cbegin()+first+sz*(delta+1);
+  }  
+
+private:
+  std::vector<Coord*> coords;
+  std::vector<long> binStart;
+  long first;
+  long last;
+};
+
 /** \}*/
 #endif
@@ -125,6 +125,13 @@ public:
       dice::slv::refine::poincareInvariantWithSegTracers_order1<Mesh>
       (s,Base::geometry).first;
   }
+
+  template <class S>
+  void checkRefine_getValues(S * const *s, long n, double *result)
+  {
+    for (long i=0;i<n;++i)
+      result[i]=checkRefine_getValue(s[i]);
+  }
  
 protected:
   
@@ -0,0 +1,6 @@
+char CXX_FLAGS[]=" -fext-numeric-literals   -Wno-sign-compare -Wno-unused-local-typedefs -Wno-unknown-pragmas -fdiagnostics-show-option -Wno-deprecated-declarations -Wno-ignored-attributes -Wno-misleading-indentation -std=c++11 -g -Wall -Wno-comment  -fno-common -Wpointer-arith -Wwrite-strings -fno-math-errno -fno-strict-aliasing -funroll-loops -DNDEBUG -O3 -march=native -fopenmp ";
+char DEFINES[]=" -DVER_MAJOR=0 -DVER_MINOR=9 -DVER_BUILD=49 -DUSE_MPI -DHAVE_BOOST -DHAVE_GMP -DHAVE_QD -DHAVE_EIGEN3 -DUSE_PTHREADS -DUSE_OPENMP -DHAVE_SPARSEHASH -DHAVE_FFTW3_THREADS -DHAVE_FFTW3_MPI -DHAVE_FFTW3 -DHAVE_CPP11 -DHAVE_TR1 -DUSE_GNU_PSORT -DHAVE_QUADMATH";
+char INCLUDES[]=" -I/usr/include -I/usr/include/x86_64-linux-gnu -I/tmp/qd/include -I/usr/include/eigen3 -I/usr/local/dice/external -I/tmp/fftw/include -I/tmp/pmstub/include -I/usr/local/include";
+char DIST_INCLUDES[]=" -I/usr/include -I/usr/include/x86_64-linux-gnu -I/tmp/qd/include -I/usr/include/eigen3 -I/root/repo/external -I/tmp/fftw/include -I/tmp/pmstub/include -I/root/repo/include";
+char LIBRARIES[]=" -L/usr/lib/x86_64-linux-gnu -lgmp -L/tmp/qd/lib -lqd -lpthread -fopenmp /tmp/fftw/lib/libfftw3_threads.a /tmp/fftw/lib/libfftw3_mpi.a /tmp/fftw/lib/libfftw3.a /tmp/pmstub/lib/libparmetis.a /tmp/pmstub/lib/libmetis.a -lquadmath";
+char COMPILER[]=" /usr/bin/mpicxx";